@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* offline analyzer for job.log files: every file is memory-mapped and cut into
+   chunks at line boundaries, worker threads scan the chunks into private stats
+   which are merged at the end, so one huge log scales as well as many small ones */
+
+#define CHUNK_SIZE (64L << 20)
+#define TYPES 4
+#define HISTOGRAM_MAX (1L << 20)   // larger values, e.g. from a corrupt line, share the last bucket
+
+int t = 2;              // service time unit the logs were produced with
+int window = 3600;      // throughput window in seconds
+int threads = 0;        // worker threads, 0 => one per CPU
+
+char type_names[TYPES] = { 'L', 'D', 'A', 'E' };
+
+typedef struct {
+    char *data;
+    long size;
+    char *path;
+} LogFile;
+
+typedef struct {
+    int file;
+    long begin;
+    long end;
+} Chunk;
+
+/* a growable array of counters indexed by seconds */
+typedef struct {
+    long *counts;
+    long size;
+} Histogram;
+
+typedef struct {
+    long jobs[TYPES];
+    long turnaround_sum[TYPES];
+    long turnaround_max[TYPES];
+    Histogram turnaround[TYPES];
+    long pad_jobs[2];
+    long pad_busy[2];           // seconds of service done on each pad
+    Histogram windows;          // completed jobs per throughput window
+    long *file_span;            // last end time seen in each file
+    long bytes;
+} Stats;
+
+LogFile *files;
+int file_count;
+Chunk *chunks;
+int chunk_count;
+int next_chunk = 0;
+
+void Grow(Histogram *histogram, long index) {
+    if (index >= histogram->size) {
+        long size = histogram->size ? histogram->size : 64;
+        while (size <= index) {
+            size *= 2;
+        }
+        long *counts = realloc(histogram->counts, size * sizeof(long));
+        if (counts == NULL) {
+            fprintf(stderr, "out of memory for %ld histogram buckets\n", size);
+            exit(1);
+        }
+        histogram->counts = counts;
+        memset(histogram->counts + histogram->size, 0, (size - histogram->size) * sizeof(long));
+        histogram->size = size;
+    }
+}
+
+static inline void Count(Histogram *histogram, long index) {
+    if (index > HISTOGRAM_MAX) {
+        index = HISTOGRAM_MAX;
+    }
+    if (index >= histogram->size) {
+        Grow(histogram, index);
+    }
+    histogram->counts[index]++;
+}
+
+void Merge(Histogram *into, Histogram *from) {
+    if (from->size == 0) {
+        return;
+    }
+    Grow(into, from->size - 1);
+    for (long i = 0; i < from->size; i++) {
+        into->counts[i] += from->counts[i];
+    }
+}
+
+int TypeIndex(char type) {
+    switch (type) {
+        case 'L': return 0;
+        case 'D': return 1;
+        case 'A': return 2;
+        default:  return 3;
+    }
+}
+
+int ServiceTime(int type) {
+    int service[TYPES] = { 1*t, 2*t, 6*t, 1*t };
+    return service[type];
+}
+
+static inline const char *SkipSpaces(const char *p, const char *end) {
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    return p;
+}
+
+static inline const char *ParseNumber(const char *p, const char *end, long *value) {
+    long v = 0;
+    p = SkipSpaces(p, end);
+    while (p < end && (unsigned) (*p - '0') < 10) {
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+    *value = v;
+    return p;
+}
+
+// scans the lines of a chunk, the header lines and anything else not starting with a digit is skipped
+void Scan(Chunk *chunk, Stats *stats) {
+    const char *p = files[chunk->file].data + chunk->begin;
+    const char *end = files[chunk->file].data + chunk->end;
+    long span = stats->file_span[chunk->file];
+    while (p < end) {
+        // memchr is vectorized in libc, the fields are parsed without ever looking back
+        const char *eol = memchr(p, '\n', end - p);
+        if (eol == NULL) {
+            eol = end;
+        }
+        if ((unsigned) (*p - '0') < 10) {
+            long id, request_time, end_time, turnaround;
+            const char *q = ParseNumber(p, eol, &id);
+            q = SkipSpaces(q, eol);
+            int type = TypeIndex(q < eol ? *q++ : 'E');
+            q = ParseNumber(q, eol, &request_time);
+            q = ParseNumber(q, eol, &end_time);
+            q = ParseNumber(q, eol, &turnaround);
+            q = SkipSpaces(q, eol);
+            int pad = (q < eol && *q == 'B') ? 1 : 0;
+
+            stats->jobs[type]++;
+            stats->turnaround_sum[type] += turnaround;
+            if (turnaround > stats->turnaround_max[type]) {
+                stats->turnaround_max[type] = turnaround;
+            }
+            Count(&stats->turnaround[type], turnaround);
+            stats->pad_jobs[pad]++;
+            stats->pad_busy[pad] += ServiceTime(type);
+            Count(&stats->windows, end_time / window);
+            if (end_time > span && end_time / window < HISTOGRAM_MAX) {
+                span = end_time;
+            }
+        }
+        p = eol + 1;
+    }
+    stats->file_span[chunk->file] = span;
+    stats->bytes += chunk->end - chunk->begin;
+}
+
+void* Worker(void *arg) {
+    Stats *stats = (Stats*) arg;
+    int index;
+    while ((index = __atomic_fetch_add(&next_chunk, 1, __ATOMIC_RELAXED)) < chunk_count) {
+        Scan(&chunks[index], stats);
+    }
+    return NULL;
+}
+
+// maps a file and cuts it into chunks that start and end on line boundaries
+int AddFile(char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    LogFile *file = &files[file_count];
+    file->path = path;
+    file->size = st.st_size;
+    file->data = NULL;
+    if (st.st_size > 0) {
+        file->data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (file->data == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        madvise(file->data, st.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    long begin = 0;
+    while (begin < file->size) {
+        long end = begin + CHUNK_SIZE;
+        if (end >= file->size) {
+            end = file->size;
+        } else {
+            char *eol = memchr(file->data + end, '\n', file->size - end);
+            end = eol == NULL ? file->size : eol - file->data + 1;
+        }
+        Chunk *grown = realloc(chunks, (chunk_count + 1) * sizeof(Chunk));
+        if (grown == NULL) {
+            return -1;
+        }
+        chunks = grown;
+        chunks[chunk_count++] = (Chunk) { .file = file_count, .begin = begin, .end = end };
+        begin = end;
+    }
+    file_count++;
+    return 0;
+}
+
+// the turnaround at or below which the given fraction of jobs finished
+long Percentile(Histogram *histogram, long total, double fraction) {
+    long rank = (long) (fraction * total + 0.999999);
+    long seen = 0;
+    for (long i = 0; i < histogram->size; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank && seen > 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void Print_Turnaround(char *name, long jobs, long sum, long max, Histogram *histogram) {
+    printf("%-8s%-10ld%-9.2f%-6ld%-6ld%-6ld%ld\n", name, jobs, jobs ? (double) sum / jobs : 0,
+        Percentile(histogram, jobs, 0.50), Percentile(histogram, jobs, 0.90), Percentile(histogram, jobs, 0.99), max);
+}
+
+int main(int argc, char **argv) {
+    // -w (int) => throughput window in seconds
+    // -j (int) => worker threads
+    // -T (int) => service time unit t of the simulation that wrote the logs
+    // every other argument is a job.log file
+    files = calloc(argc, sizeof(LogFile));
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-w")) {window = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-j")) {threads = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-T")) {t = atoi(argv[++i]);}
+        else if (AddFile(argv[i]) != 0) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (file_count == 0) {
+        fprintf(stderr, "usage: %s [-w window] [-j threads] [-T t] job.log...\n", argv[0]);
+        return 1;
+    }
+    if (window <= 0) {
+        window = 3600;
+    }
+    if (threads <= 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > chunk_count) {
+        threads = chunk_count > 0 ? chunk_count : 1;
+    }
+
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    Stats *stats = calloc(threads, sizeof(Stats));
+    pthread_t *workers = malloc(threads * sizeof(pthread_t));
+    for (int i = 0; i < threads; i++) {
+        stats[i].file_span = calloc(file_count, sizeof(long));
+        pthread_create(&workers[i], NULL, Worker, &stats[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    // everything is merged into the first worker's stats
+    Stats *total = &stats[0];
+    for (int i = 1; i < threads; i++) {
+        for (int type = 0; type < TYPES; type++) {
+            total->jobs[type] += stats[i].jobs[type];
+            total->turnaround_sum[type] += stats[i].turnaround_sum[type];
+            if (stats[i].turnaround_max[type] > total->turnaround_max[type]) {
+                total->turnaround_max[type] = stats[i].turnaround_max[type];
+            }
+            Merge(&total->turnaround[type], &stats[i].turnaround[type]);
+        }
+        for (int pad = 0; pad < 2; pad++) {
+            total->pad_jobs[pad] += stats[i].pad_jobs[pad];
+            total->pad_busy[pad] += stats[i].pad_busy[pad];
+        }
+        Merge(&total->windows, &stats[i].windows);
+        for (int file = 0; file < file_count; file++) {
+            if (stats[i].file_span[file] > total->file_span[file]) {
+                total->file_span[file] = stats[i].file_span[file];
+            }
+        }
+        total->bytes += stats[i].bytes;
+    }
+
+    long jobs = 0, turnaround_sum = 0, turnaround_max = 0, span = 0, longest = 0;
+    Histogram all = { NULL, 0 };
+    for (int type = 0; type < TYPES; type++) {
+        jobs += total->jobs[type];
+        turnaround_sum += total->turnaround_sum[type];
+        if (total->turnaround_max[type] > turnaround_max) {
+            turnaround_max = total->turnaround_max[type];
+        }
+        Merge(&all, &total->turnaround[type]);
+    }
+    for (int file = 0; file < file_count; file++) {
+        span += total->file_span[file];
+        if (total->file_span[file] > longest) {
+            longest = total->file_span[file];
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    double seconds = (finished.tv_sec - started.tv_sec) + (finished.tv_nsec - started.tv_nsec) / 1e9;
+
+    printf("%d files, %ld jobs, %.1f MB in %.3f sec (%.0f MB/s, %d threads)\n\n", file_count, jobs,
+        total->bytes / 1e6, seconds, total->bytes / 1e6 / (seconds > 0 ? seconds : 1e-9), threads);
+
+    printf("%-8s%-10s%-9s%-6s%-6s%-6s%s\n", "Status", "Count", "Mean", "P50", "P90", "P99", "Max");
+    for (int type = 0; type < TYPES; type++) {
+        char name[2] = { type_names[type], 0 };
+        Print_Turnaround(name, total->jobs[type], total->turnaround_sum[type], total->turnaround_max[type], &total->turnaround[type]);
+    }
+    Print_Turnaround("all", jobs, turnaround_sum, turnaround_max, &all);
+
+    printf("\n%-5s%-10s%-11s%s\n", "Pad", "Count", "Busy_Sec", "Utilization");
+    for (int pad = 0; pad < 2; pad++) {
+        printf("%-5c%-10ld%-11ld%.1f%%\n", 'A' + pad, total->pad_jobs[pad], total->pad_busy[pad],
+            span ? 100.0 * total->pad_busy[pad] / span : 0);
+    }
+
+    // windows are aligned on each run's own start, rates are per run
+    printf("\n%-14s%-10s%s\n", "Window_Start", "Jobs", "Jobs/Hour");
+    for (long i = 0; i < total->windows.size; i++) {
+        if (i * window > longest) {
+            break;
+        }
+        printf("%-14ld%-10ld%.1f\n", i * window, total->windows.counts[i],
+            total->windows.counts[i] * 3600.0 / window / file_count);
+    }
+    if (total->windows.size > HISTOGRAM_MAX && total->windows.counts[HISTOGRAM_MAX] > 0) {
+        printf("%-14s%ld\n", "later", total->windows.counts[HISTOGRAM_MAX]);
+    }
+    return 0;
+}
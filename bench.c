@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <math.h>
+
+#include "queue.c"
+
+#define t 2
+
+#include "policy.c"
+
+/* compares the scheduling policies in policy.c: the simulator's arrival model is
+   replayed in virtual time, one tick per second, so every policy sees exactly the
+   same jobs for a given seed and a simulated week takes well under a second */
+
+int simulationTime = 7*24*3600; // simulated seconds per run
+int seed = 10;                  // seed of the first run
+int runs = 5;                   // runs per policy, seeds seed .. seed+runs-1
+float p = 0.2;                  // probability of a ground job (launch & assembly)
+
+typedef struct {
+    Policy *policy;
+    long completed;
+    long turnaround_sum;
+    int *turnarounds;
+    long capacity;
+    long decisions;
+    long decision_ns;
+    double throughput;          // jobs per simulated hour
+    int p99;
+} Result;
+
+double probability(unsigned int *state) {
+    return (double) rand_r(state) / (double) RAND_MAX;
+}
+
+long Now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+void Record(Result *result, int turnaround) {
+    if (result->completed == result->capacity) {
+        long capacity = result->capacity ? result->capacity * 2 : 1 << 16;
+        int *turnarounds = realloc(result->turnarounds, capacity * sizeof(int));
+        if (turnarounds == NULL) {
+            fprintf(stderr, "out of memory for %ld turnarounds\n", capacity);
+            exit(1);
+        }
+        result->turnarounds = turnarounds;
+        result->capacity = capacity;
+    }
+    result->turnarounds[result->completed++] = turnaround;
+    result->turnaround_sum += turnaround;
+}
+
+// an idle pad starts the head of its queue, remaining is 0 while it is idle;
+// the job is removed by ID when done, like the simulator's pads do
+void Advance(Queue *pad, Job *job, int *remaining, long now, Result *result) {
+    if (*remaining == 0 && !isEmpty(pad)) {
+        *job = pad->head->data;
+        *remaining = ServiceTime(job->type);
+    }
+    if (*remaining > 0 && --*remaining == 0) {
+        RemoveJob(pad, job->ID);
+        Record(result, now + 1 - job->request_time);
+    }
+}
+
+void Run(Policy *policy, unsigned int rng, Result *result) {
+    Queue *land = ConstructQueue(INT_MAX);
+    Queue *launch = ConstructQueue(INT_MAX);
+    Queue *assembly = ConstructQueue(INT_MAX);
+    Queue *emergency = ConstructQueue(INT_MAX);
+    Queue *padA = ConstructQueue(INT_MAX);
+    Queue *padB = ConstructQueue(INT_MAX);
+    Job padA_job;               // in service while its pad's remaining is above 0
+    Job padB_job;
+    int padA_remaining = 0;
+    int padB_remaining = 0;
+    int emergency_counter = 0;
+    int ID = 1;
+
+    if (policy->reset != NULL) {
+        policy->reset();
+    }
+
+    Job first = { .ID = ID++, .request_time = 0, .type = 'D' };
+    Enqueue(launch, first);
+
+    for (long now = 0; now <= simulationTime; now++) {
+        if (now > 0 && now % t == 0) {
+            // the generator threads wake up every t seconds
+            if (probability(&rng) < 1 - p) {
+                Job job = { .ID = ID++, .request_time = now, .type = 'L' };
+                Enqueue(land, job);
+            }
+            if (probability(&rng) < p / 2) {
+                Job job = { .ID = ID++, .request_time = now, .type = 'D' };
+                Enqueue(launch, job);
+            }
+            if (probability(&rng) < p / 2) {
+                Job job = { .ID = ID++, .request_time = now, .type = 'A' };
+                Enqueue(assembly, job);
+            }
+            if (++emergency_counter == 40) {
+                Job job1 = { .ID = ID++, .request_time = now, .type = 'E' };
+                Job job2 = { .ID = ID++, .request_time = now, .type = 'E' };
+                Enqueue(emergency, job1);
+                Enqueue(emergency, job2);
+                emergency_counter = 0;
+            }
+        }
+
+        // emergencies follow the control tower's fixed rules whatever the policy
+        while (!isEmpty(emergency)) {
+            Job job = Dequeue(emergency);
+            if (padA_remaining == 0) {
+                job.pad = 'A';
+                EnqueueFirst(padA, job);
+            } else if (padB_remaining == 0) {
+                job.pad = 'B';
+                EnqueueFirst(padB, job);
+            } else if (padA_remaining >= padB_remaining) {
+                job.pad = 'B';
+                EnqueueSecond(padB, job);
+            } else {
+                job.pad = 'A';
+                EnqueueSecond(padA, job);
+            }
+        }
+
+        TowerState state = {
+            .land = land,
+            .launch = launch,
+            .assembly = assembly,
+            .padA = padA,
+            .padB = padB,
+            .padA_job = padA_remaining > 0 ? padA_job.ID : 0,
+            .padB_job = padB_remaining > 0 ? padB_job.ID : 0,
+            .padA_remaining = padA_remaining,
+            .padB_remaining = padB_remaining,
+            .now = now
+        };
+        // the real tower spins, so a policy gets called until it has nothing to move
+        int moved;
+        do {
+            long start = Now_ns();
+            moved = policy->dispatch(&state);
+            result->decision_ns += Now_ns() - start;
+            result->decisions++;
+        } while (moved > 0);
+
+        Advance(padA, &padA_job, &padA_remaining, now, result);
+        Advance(padB, &padB_job, &padB_remaining, now, result);
+    }
+
+    DestructQueue(land);
+    DestructQueue(launch);
+    DestructQueue(assembly);
+    DestructQueue(emergency);
+    DestructQueue(padA);
+    DestructQueue(padB);
+}
+
+int CompareInt(const void *a, const void *b) {
+    return *(int*) a - *(int*) b;
+}
+
+// best throughput first, then the lower p99 turnaround, then the cheaper decision
+int CompareResult(const void *a, const void *b) {
+    const Result *x = a;
+    const Result *y = b;
+    // throughputs within the printed precision count as a tie
+    long x_throughput = lround(x->throughput * 10);
+    long y_throughput = lround(y->throughput * 10);
+    if (x_throughput != y_throughput) {
+        return x_throughput < y_throughput ? 1 : -1;
+    }
+    if (x->p99 != y->p99) {
+        return x->p99 - y->p99;
+    }
+    double x_ns = (double) x->decision_ns / x->decisions;
+    double y_ns = (double) y->decision_ns / y->decisions;
+    return (x_ns > y_ns) - (x_ns < y_ns);
+}
+
+int main(int argc, char **argv) {
+    // -t (int) => simulated seconds per run
+    // -s (int) => seed of the first run
+    // -r (int) => runs per policy, one seed each
+    // -p (float) => sets p
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-t")) {simulationTime = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-s")) {seed = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-r")) {runs = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-p")) {p = atof(argv[++i]);}
+    }
+
+    Result results[POLICIES];
+    memset(results, 0, sizeof(results));
+    for (int i = 0; i < POLICIES; i++) {
+        results[i].policy = &policies[i];
+        for (int run = 0; run < runs; run++) {
+            Run(&policies[i], seed + run, &results[i]);
+        }
+        qsort(results[i].turnarounds, results[i].completed, sizeof(int), CompareInt);
+        long p99_index = (results[i].completed * 99 + 99) / 100 - 1;
+        results[i].p99 = results[i].completed ? results[i].turnarounds[p99_index] : 0;
+        results[i].throughput = results[i].completed * 3600.0 / ((double) (simulationTime + 1) * runs);
+    }
+    qsort(results, POLICIES, sizeof(Result), CompareResult);
+
+    printf("%d runs of %d sec, p = %.2f, seeds %d..%d\n", runs, simulationTime, p, seed, seed + runs - 1);
+    printf("%-6s%-11s%-12s%-17s%-16s%s\n", "Rank", "Policy", "Jobs/Hour", "Mean_Turnaround", "P99_Turnaround", "Decision_ns");
+    for (int i = 0; i < POLICIES; i++) {
+        Result *r = &results[i];
+        printf("%-6d%-11s%-12.1f%-17.2f%-16d%.1f\n", i + 1, r->policy->name, r->throughput,
+            r->completed ? (double) r->turnaround_sum / r->completed : 0, r->p99,
+            (double) r->decision_ns / r->decisions);
+        free(r->turnarounds);
+    }
+    return 0;
+}
@@ -2,17 +2,39 @@
 #include <sys/time.h>
 #include <string.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 
 #include "queue.c"
+#include "metrics.h"
+#include "trace.c"
 
 #define t 2
 #define MAX_SPACECRAFT 3*(simulationTime + 1)
 
+#include "policy.c"
+
+#define OVERLOAD_BLOCK 0     // generator waits until the control tower makes room
+#define OVERLOAD_SHED  1     // job is dropped and counted as rejected
+#define OVERLOAD_SPILL 2     // job is parked in an on-disk overflow file
+
 int simulationTime = 120;    // simulation time
 int seed = 10;               // seed for randomness
 int emergencyFrequency = 40; // frequency of emergency
 float p = 0.2;               // probability of a ground job (launch & assembly)
 int n = 0;                 // start logging after n seconds
+int queueCapacity = 0;       // fixed capacity of the waiting queues, 0 => MAX_SPACECRAFT
+int overloadPolicy = OVERLOAD_SHED; // what happens to arrivals when a waiting queue is full
+char *checkpoint_file = NULL; // write a checkpoint image here
+int checkpointTime = -1;     // take the checkpoint after this many seconds, -1 => at the end
+char *restore_file = NULL;   // resume from this checkpoint image
+char *metrics_name = NULL;   // publish live metrics into this shared-memory segment
+bool preemption = FALSE;     // emergencies interrupt the D/A/L job in service
+Policy *policy = &policies[0]; // how the control tower dispatches to the pads
+char *trace_file = NULL;     // write a Chrome trace-event timeline here
 
 Queue *launch_queue;
 Queue *land_queue;
@@ -21,7 +43,50 @@ Queue *emergency_queue;
 Queue *padA_queue;
 Queue *padB_queue;
 
+/* admission control state of a waiting queue, guarded by the queue's mutex */
+typedef struct {
+    pthread_cond_t not_full; // signalled when the control tower makes room
+    FILE *spill;             // compact on-disk overflow, jobs kept in arrival order
+    long spill_head;         // index of the oldest job in the spill file
+    long spill_size;         // number of jobs waiting in the spill file
+    long admitted;
+    long rejected;
+    long delayed;
+    long spilled;
+    int policy;              // overload policy of this queue
+    int index;               // slot in the metrics segment
+} Overflow;
+
+Overflow launch_overflow;
+Overflow land_overflow;
+Overflow assembly_overflow;
+Overflow emergency_overflow;
+
+#define CHECKPOINT_MAGIC   "SCCK"
+#define CHECKPOINT_VERSION 4
+
+/* header of a checkpoint image, followed by the Job records of every queue in
+   launch, land, assembly, emergency, padA, padB order; times are relative to start_time */
+typedef struct {
+    char magic[4];
+    int version;
+    int elapsed;              // simulated clock
+    int ID;
+    unsigned int rng_state;
+    int emergency_counter;
+    int pad_working[2];
+    int pad_work_time[2];
+    char pad_work_job[2];
+    int queue_size[6];
+    long admitted[4];         // admission counters of the launch, land, assembly and emergency queues
+    long rejected[4];
+    long delayed[4];
+    long spilled[4];
+} Checkpoint;
+
 int ID;
+unsigned int rng_state;
+int emergency_counter = 0;
 FILE *job_log;
 char file_name[] = "job.log"; 
 bool padA_working = FALSE;
@@ -30,6 +95,16 @@ time_t padA_work_time;
 time_t padB_work_time;
 char padA_work_job;
 char padB_work_job;
+int padA_work_id;
+int padB_work_id;
+struct timespec padA_deadline;   // when the job in service will be done
+struct timespec padB_deadline;
+bool padA_preempt = FALSE;       // set by the control tower to interrupt the pad
+bool padB_preempt = FALSE;
+bool padA_reread = FALSE;        // an emergency went to the head before the pad started a job
+bool padB_reread = FALSE;
+pthread_cond_t padA_preempt_cond;
+pthread_cond_t padB_preempt_cond;
 
 pthread_mutex_t launch_queue_mutex;
 pthread_mutex_t land_queue_mutex;
@@ -40,6 +115,9 @@ pthread_mutex_t padB_queue_mutex;
 pthread_mutex_t padA_work_mutex;
 pthread_mutex_t padB_work_mutex;
 pthread_mutex_t ID_mutex;
+pthread_mutex_t rng_mutex;
+
+Metrics *metrics = NULL;
 pthread_mutex_t file_mutex;
 
 time_t start_time, end_time; 
@@ -52,7 +130,27 @@ void* ControlTower(void *arg);
 void* PadA(void *arg);
 void* PadB(void *arg);
 void* Print_Jobs_Terminal(void *arg);
+void Print_Queue_IDs(Queue *queue, pthread_mutex_t *mutex, char type, bool with_type);
 void* KeepLog(Job job);
+void Admit(Queue *queue, pthread_mutex_t *mutex, Overflow *overflow, Job job);
+void Refill(Queue *queue, Overflow *overflow);
+void Spill(Overflow *overflow, Job job);
+void Print_Admission_Report();
+void* CheckpointJob(void *arg);
+void TracePadEnqueues(Queue *pad, int before, const char *name);
+int WriteCheckpoint(char *path);
+int RestoreCheckpoint(char *path);
+int OpenMetrics(char *name);
+void CloseMetrics(char *name);
+void PublishQueue(int index, Queue *queue);
+void PublishPad(int pad, bool busy, Job job);
+void PublishCompletion(Job job);
+void PublishRejected(char type, long rejected);
+int PadWait(pthread_mutex_t *work_mutex, pthread_cond_t *preempt_cond, bool *preempt, struct timespec *deadline, int service_ms);
+int Remaining_ms(struct timespec *deadline);
+void PadIdle(pthread_mutex_t *work_mutex, pthread_cond_t *preempt_cond, bool *reread);
+void WakePad(pthread_cond_t *preempt_cond, bool *reread);
+int Now_ms();
 int FindPadARemainingTime();
 int FindPadBRemainingTime();
 double probability();
@@ -90,17 +188,62 @@ int main(int argc,char **argv) {
     // -t (int) => simulation time in seconds
     // -s (int) => change the random seed
     // -n (int) => change the start log time
+    // -q (int) => fixed capacity of the landing, launch and assembly queues
+    // -o (block|shed|spill) => overload policy when one of them is full
+    // -c (file) => write a checkpoint image of the simulation state
+    // -ct (int) => take the checkpoint after this many seconds
+    // -r (file) => restore from a checkpoint image and continue
+    // -m (name) => publish live metrics into a POSIX shared-memory segment, see monitor.c
+    // -e => emergencies preempt the job in service when both pads are busy
+    // -P (default|sec|wfq|lookahead) => scheduling policy of the control tower, see policy.c
+    // -trace (file) => record a timeline and write it as Chrome trace-event JSON
     for(int i=1; i<argc; i++){
         if(!strcmp(argv[i], "-p")) {p = atof(argv[++i]);}
         else if(!strcmp(argv[i], "-t")) {simulationTime = atoi(argv[++i]);}
         else if(!strcmp(argv[i], "-s"))  {seed = atoi(argv[++i]);}
         else if(!strcmp(argv[i], "-n"))  {n = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-q"))  {queueCapacity = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-o"))  {
+            i++;
+            if(!strcmp(argv[i], "block")) {overloadPolicy = OVERLOAD_BLOCK;}
+            else if(!strcmp(argv[i], "shed")) {overloadPolicy = OVERLOAD_SHED;}
+            else if(!strcmp(argv[i], "spill")) {overloadPolicy = OVERLOAD_SPILL;}
+            else {
+                fprintf(stderr, "unknown overload policy %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(!strcmp(argv[i], "-c"))  {checkpoint_file = argv[++i];}
+        else if(!strcmp(argv[i], "-ct")) {checkpointTime = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-r"))  {restore_file = argv[++i];}
+        else if(!strcmp(argv[i], "-m"))  {metrics_name = argv[++i];}
+        else if(!strcmp(argv[i], "-e"))  {preemption = TRUE;}
+        else if(!strcmp(argv[i], "-trace")) {trace_file = argv[++i];}
+        else if(!strcmp(argv[i], "-P"))  {
+            policy = FindPolicy(argv[++i]);
+            if (policy == NULL) {
+                fprintf(stderr, "unknown policy %s\n", argv[i]);
+                return 1;
+            }
+        }
     }
     
-    srand(seed); // feed the seed
+    rng_state = seed; // feed the seed
+    if (trace_file != NULL) {
+        TraceStart();
+        TRACE_THREAD("main");
+    }
+    if (policy->reset != NULL) {
+        policy->reset();
+    }
     job_log = fopen(file_name,"w");
-    fprintf(job_log,"EventID  Status  Request_Time  End_Time  Turnaround_Time  Pad\n");
-    fprintf(job_log,"-------------------------------------------------------------\n");
+    if (preemption) {
+        fprintf(job_log,"EventID  Status  Request_Time  End_Time  Turnaround_Time  Pad  Preempted\n");
+        fprintf(job_log,"------------------------------------------------------------------------\n");
+    } else {
+        fprintf(job_log,"EventID  Status  Request_Time  End_Time  Turnaround_Time  Pad\n");
+        fprintf(job_log,"-------------------------------------------------------------\n");
+    }
     fclose(job_log);
     
     /* Queue usage example
@@ -113,13 +256,18 @@ int main(int argc,char **argv) {
         DestructQueue(myQ);
     */
 
-    launch_queue = ConstructQueue(MAX_SPACECRAFT);
-    land_queue = ConstructQueue(MAX_SPACECRAFT);
-    assembly_queue = ConstructQueue(MAX_SPACECRAFT);
+    // a fixed capacity keeps memory constant no matter how long the run is
+    int capacity = queueCapacity > 0 ? queueCapacity : MAX_SPACECRAFT;
+
+    launch_queue = ConstructQueue(capacity);
+    land_queue = ConstructQueue(capacity);
+    assembly_queue = ConstructQueue(capacity);
+    // emergencies are never shed, two arrive every 40*t seconds and leave at once
     emergency_queue = ConstructQueue(MAX_SPACECRAFT);
 
-    padA_queue = ConstructQueue(MAX_SPACECRAFT);
-    padB_queue = ConstructQueue(MAX_SPACECRAFT);
+    // the policies leave EMERGENCY_ROOM slots free so an emergency always fits on a pad
+    padA_queue = ConstructQueue(capacity + EMERGENCY_ROOM);
+    padB_queue = ConstructQueue(capacity + EMERGENCY_ROOM);
 
     pthread_mutex_init(&launch_queue_mutex, NULL);
     pthread_mutex_init(&land_queue_mutex, NULL);
@@ -129,7 +277,29 @@ int main(int argc,char **argv) {
     pthread_mutex_init(&padB_queue_mutex, NULL);
     pthread_mutex_init(&padA_work_mutex, NULL);
     pthread_mutex_init(&padB_work_mutex, NULL);
+    pthread_cond_init(&padA_preempt_cond, NULL);
+    pthread_cond_init(&padB_preempt_cond, NULL);
     pthread_mutex_init(&ID_mutex, NULL);
+    pthread_mutex_init(&rng_mutex, NULL);
+
+    launch_overflow.index = METRICS_LAUNCH;
+    land_overflow.index = METRICS_LAND;
+    assembly_overflow.index = METRICS_ASSEMBLY;
+    emergency_overflow.index = METRICS_EMERGENCY;
+    launch_overflow.policy = overloadPolicy;
+    land_overflow.policy = overloadPolicy;
+    assembly_overflow.policy = overloadPolicy;
+    emergency_overflow.policy = OVERLOAD_BLOCK;
+
+    if (metrics_name != NULL && OpenMetrics(metrics_name) != 0) {
+        fprintf(stderr, "cannot open metrics segment %s\n", metrics_name);
+        return 1;
+    }
+
+    pthread_cond_init(&launch_overflow.not_full, NULL);
+    pthread_cond_init(&land_overflow.not_full, NULL);
+    pthread_cond_init(&assembly_overflow.not_full, NULL);
+    pthread_cond_init(&emergency_overflow.not_full, NULL);
 
     pthread_t launch_thread;
     pthread_t land_thread;
@@ -139,15 +309,27 @@ int main(int argc,char **argv) {
     pthread_t padB_thread;
     pthread_t control_tower_thread;
     pthread_t print_jobs_terminal_thread;
+    pthread_t checkpoint_thread;
 
-    ID = 1;
+    if (restore_file != NULL) {
+        if (RestoreCheckpoint(restore_file) != 0) {
+            fprintf(stderr, "cannot restore checkpoint %s\n", restore_file);
+            return 1;
+        }
+    } else {
+        ID = 1;
 
-    Job job = { .ID = ID, .request_time = time(NULL), .type = 'D', .pad = 'A' };
-    ID++;
-    Enqueue(launch_queue, job);
+        Job job = { .ID = ID, .request_time = time(NULL), .type = 'D', .pad = 'A' };
+        ID++;
+        Admit(launch_queue, &launch_queue_mutex, &launch_overflow, job);
 
-    time(&start_time);
+        time(&start_time);
+    }
     end_time = start_time + simulationTime + 1;
+    if (metrics != NULL) {
+        // monitors derive the clock from start_time, the writers never touch it again
+        __atomic_store_n(&metrics->start_time, start_time, __ATOMIC_RELEASE);
+    }
 
     pthread_create(&launch_thread, NULL, LaunchJob, NULL);
     pthread_create(&land_thread, NULL, LandingJob, NULL);
@@ -157,6 +339,9 @@ int main(int argc,char **argv) {
     pthread_create(&padB_thread, NULL, PadB, NULL);
     pthread_create(&control_tower_thread, NULL, ControlTower, NULL);
     pthread_create(&print_jobs_terminal_thread, NULL, Print_Jobs_Terminal, NULL);
+    if (checkpoint_file != NULL) {
+        pthread_create(&checkpoint_thread, NULL, CheckpointJob, NULL);
+    }
 
     pthread_join(launch_thread, NULL);
     pthread_join(land_thread, NULL);
@@ -166,6 +351,17 @@ int main(int argc,char **argv) {
     pthread_join(padB_thread, NULL);
     pthread_join(control_tower_thread, NULL);
     pthread_join(print_jobs_terminal_thread, NULL);
+    if (checkpoint_file != NULL) {
+        pthread_join(checkpoint_thread, NULL);
+    }
+
+    Print_Admission_Report();
+    if (tracing && TraceWrite(trace_file) != 0) {
+        fprintf(stderr, "cannot write trace %s\n", trace_file);
+    }
+    if (metrics != NULL) {
+        CloseMetrics(metrics_name);
+    }
 
     DestructQueue(launch_queue);
     DestructQueue(land_queue);
@@ -180,17 +376,33 @@ int main(int argc,char **argv) {
     pthread_mutex_destroy(&emergency_queue_mutex);
     pthread_mutex_destroy(&padA_queue_mutex);
     pthread_mutex_destroy(&padB_queue_mutex);
+    pthread_cond_destroy(&padA_preempt_cond);
+    pthread_cond_destroy(&padB_preempt_cond);
     pthread_mutex_destroy(&ID_mutex);
+    pthread_mutex_destroy(&rng_mutex);
+
+    Overflow *overflows[] = { &launch_overflow, &land_overflow, &assembly_overflow, &emergency_overflow };
+    for(int i = 0; i < 4; i++) {
+        pthread_cond_destroy(&overflows[i]->not_full);
+        if(overflows[i]->spill != NULL) {
+            fclose(overflows[i]->spill);
+        }
+    }
 
     return 0;
 }
 
 double probability() {
-    return (double) rand() / (double) RAND_MAX;
+    // rand_r keeps the generator state in rng_state so it can be checkpointed
+    pthread_mutex_lock(&rng_mutex);
+    int r = rand_r(&rng_state);
+    pthread_mutex_unlock(&rng_mutex);
+    return (double) r / (double) RAND_MAX;
 }
 
 // the function that creates plane threads for landing
 void* LandingJob(void *arg) {
+    TRACE_THREAD("LandingJob");
     while (end_time > time(NULL)) {
         pthread_sleep(1*t);
 
@@ -200,15 +412,14 @@ void* LandingJob(void *arg) {
             ID++;
             pthread_mutex_unlock(&ID_mutex);
             
-            pthread_mutex_lock(&land_queue_mutex);
-            Enqueue(land_queue, job);
-            pthread_mutex_unlock(&land_queue_mutex);
+            Admit(land_queue, &land_queue_mutex, &land_overflow, job);
         }
     }
 }
 
 // the function that creates plane threads for departure
 void* LaunchJob(void *arg) {
+    TRACE_THREAD("LaunchJob");
     while (end_time > time(NULL)) {
         pthread_sleep(1*t);
 
@@ -218,15 +429,14 @@ void* LaunchJob(void *arg) {
             ID++;
             pthread_mutex_unlock(&ID_mutex);
             
-            pthread_mutex_lock(&launch_queue_mutex);
-            Enqueue(launch_queue, job);
-            pthread_mutex_unlock(&launch_queue_mutex);
+            Admit(launch_queue, &launch_queue_mutex, &launch_overflow, job);
         }
     }
 }
 
 // the function that creates plane threads for emergency landing
 void* AssemblyJob(void *arg){
+    TRACE_THREAD("AssemblyJob");
     while (end_time > time(NULL)) {
         pthread_sleep(1*t);
 
@@ -236,77 +446,112 @@ void* AssemblyJob(void *arg){
             ID++;
             pthread_mutex_unlock(&ID_mutex);
             
-            pthread_mutex_lock(&assembly_queue_mutex);
-            Enqueue(assembly_queue, job);
-            pthread_mutex_unlock(&assembly_queue_mutex);
+            Admit(assembly_queue, &assembly_queue_mutex, &assembly_overflow, job);
         }
     }
 }
 
 // the function that creates plane threads for emergency landing
 void* EmergencyJob(void *arg) {
-    int counter = 0;
+    TRACE_THREAD("EmergencyJob");
     while (end_time > time(NULL)) {
         pthread_sleep(1*t);
-        counter++;
-        if(counter == 40) {
-            pthread_mutex_lock(&ID_mutex);
+        // the counter is checkpointed, ID_mutex guards it together with ID
+        pthread_mutex_lock(&ID_mutex);
+        emergency_counter++;
+        if(emergency_counter == 40) {
             Job job1 = { .ID = ID,  .type = 'E', .request_time = time(NULL) };
             ID++;
             Job job2 = { .ID = ID,  .type = 'E', .request_time = time(NULL) };
             ID++;
+            emergency_counter = 0;
             pthread_mutex_unlock(&ID_mutex);
             
-            pthread_mutex_lock(&emergency_queue_mutex);
-            Enqueue(emergency_queue, job1);
-            Enqueue(emergency_queue, job2);
-            pthread_mutex_unlock(&emergency_queue_mutex);
-            counter = 0;
+            Admit(emergency_queue, &emergency_queue_mutex, &emergency_overflow, job1);
+            Admit(emergency_queue, &emergency_queue_mutex, &emergency_overflow, job2);
+        } else {
+            pthread_mutex_unlock(&ID_mutex);
         }
 
     }
 }
 
 void* PadA(void *arg) {
+    TRACE_THREAD("PadA");
     while (end_time > time(NULL)) {
         pthread_mutex_lock(&padA_queue_mutex);
         if (isEmpty(padA_queue)) {
             pthread_mutex_unlock(&padA_queue_mutex);
-            pthread_sleep(t);
+            PadIdle(&padA_work_mutex, &padA_preempt_cond, &padA_reread);
         } else {
             Job job = padA_queue->head->data;
 
             pthread_mutex_unlock(&padA_queue_mutex);
-            if (job.type == 'D') {
-                pthread_mutex_lock(&padA_work_mutex);
-                padA_working = TRUE;
-                padA_work_time = time(NULL);
-                padA_work_job = 'D';
-                pthread_mutex_unlock(&padA_work_mutex);
-                pthread_sleep(2*t);
-            } else if (job.type == 'L') {
-                pthread_mutex_lock(&padA_work_mutex);
-                padA_working = TRUE;
-                padA_work_time = time(NULL);
-                padA_work_job = 'L';
-                pthread_mutex_unlock(&padA_work_mutex);
-                pthread_sleep(1*t);
-            } else if (job.type == 'E') {
-                pthread_mutex_lock(&padA_work_mutex);
-                padA_working = TRUE;
-                padA_work_time = time(NULL);
-                padA_work_job = 'E';
+
+            int service_time = job.type == 'D' ? 2*t : 1*t;
+            // a preempted or checkpointed job only needs what was left of it
+            int remaining = job.started ? job.remaining : service_time * 1000;
+            bool resumed = job.interrupted;
+            if (resumed) {
+                // the queued copy is the one a checkpoint saves
+                job.preempted += Now_ms() - job.interrupted_at;
+                job.interrupted = FALSE;
+                pthread_mutex_lock(&padA_queue_mutex);
+                UpdateJob(padA_queue, job);
+                pthread_mutex_unlock(&padA_queue_mutex);
+            }
+
+            pthread_mutex_lock(&padA_work_mutex);
+            if (padA_reread) {
+                // an emergency was put in front of this job before it started
+                padA_reread = FALSE;
                 pthread_mutex_unlock(&padA_work_mutex);
-                pthread_sleep(1*t);
+                if (resumed) {
+                    // still preempted until it is back in service
+                    job.interrupted = TRUE;
+                    job.interrupted_at = Now_ms();
+                    pthread_mutex_lock(&padA_queue_mutex);
+                    UpdateJob(padA_queue, job);
+                    pthread_mutex_unlock(&padA_queue_mutex);
+                }
+                continue;
+            }
+            padA_working = TRUE;
+            padA_work_time = time(NULL) - (service_time * 1000 - remaining) / 1000;
+            padA_work_job = job.type;
+            padA_work_id = job.ID;
+            PublishPad(0, TRUE, job);
+            long service_start = TRACE_NOW();
+            remaining = PadWait(&padA_work_mutex, &padA_preempt_cond, &padA_preempt, &padA_deadline, remaining);
+            if (remaining > 0) {
+                padA_working = FALSE;
+                PublishPad(0, FALSE, job);
+            }
+            pthread_mutex_unlock(&padA_work_mutex);
+            TRACE_COMPLETE(remaining > 0 ? "preempted" : TraceJobName(job.type), "pad", service_start, job.ID, job.type);
+
+            if (remaining > 0) {
+                // the emergency is now at the head, the job resumes right after it
+                job.started = TRUE;
+                job.remaining = remaining;
+                job.interrupted = TRUE;
+                job.interrupted_at = Now_ms();
+                pthread_mutex_lock(&padA_queue_mutex);
+                UpdateJob(padA_queue, job);
+                pthread_mutex_unlock(&padA_queue_mutex);
+                continue;
             }
             job.end_time = time(NULL);
 
             pthread_mutex_lock(&padA_queue_mutex);
-            Dequeue(padA_queue);
+            RemoveJob(padA_queue, job.ID);
+            PublishQueue(METRICS_PADA, padA_queue);
             pthread_mutex_unlock(&padA_queue_mutex);
 
             pthread_mutex_lock(&padA_work_mutex);
             padA_working = FALSE;
+            padA_preempt = FALSE;
+            PublishPad(0, FALSE, job);
             pthread_mutex_unlock(&padA_work_mutex);
 
             KeepLog(job);
@@ -315,46 +560,81 @@ void* PadA(void *arg) {
 }
 
 void* PadB(void *arg) {
+    TRACE_THREAD("PadB");
     while (end_time > time(NULL)) {
         pthread_mutex_lock(&padB_queue_mutex);
         if (isEmpty(padB_queue)) {
             pthread_mutex_unlock(&padB_queue_mutex);
-            pthread_sleep(t);
+            PadIdle(&padB_work_mutex, &padB_preempt_cond, &padB_reread);
         } else {
             Job job = padB_queue->head->data;
 
             pthread_mutex_unlock(&padB_queue_mutex);
-            if (job.type == 'A') {
-                pthread_mutex_lock(&padB_work_mutex);
-                padB_working = TRUE;
-                padB_work_time = time(NULL);
-                padB_work_job = 'A';
-                pthread_mutex_unlock(&padB_work_mutex);
-                pthread_sleep(6*t);
-            } else if (job.type == 'L') {
-                pthread_mutex_lock(&padB_work_mutex);
-                padB_working = TRUE;
-                padB_work_time = time(NULL);
-                padB_work_job = 'L';
-                pthread_mutex_unlock(&padB_work_mutex);
-                pthread_sleep(1*t);
-            } else if (job.type == 'E') {
-                pthread_mutex_lock(&padB_work_mutex);
-                padB_working = TRUE;
-                padB_work_time = time(NULL);
-                padB_work_job = 'E';
-                pthread_mutex_unlock(&padB_work_mutex);
-                pthread_sleep(1*t);
+
+            int service_time = job.type == 'A' ? 6*t : 1*t;
+            // a preempted or checkpointed job only needs what was left of it
+            int remaining = job.started ? job.remaining : service_time * 1000;
+            bool resumed = job.interrupted;
+            if (resumed) {
+                // the queued copy is the one a checkpoint saves
+                job.preempted += Now_ms() - job.interrupted_at;
+                job.interrupted = FALSE;
+                pthread_mutex_lock(&padB_queue_mutex);
+                UpdateJob(padB_queue, job);
+                pthread_mutex_unlock(&padB_queue_mutex);
             }
 
+            pthread_mutex_lock(&padB_work_mutex);
+            if (padB_reread) {
+                // an emergency was put in front of this job before it started
+                padB_reread = FALSE;
+                pthread_mutex_unlock(&padB_work_mutex);
+                if (resumed) {
+                    // still preempted until it is back in service
+                    job.interrupted = TRUE;
+                    job.interrupted_at = Now_ms();
+                    pthread_mutex_lock(&padB_queue_mutex);
+                    UpdateJob(padB_queue, job);
+                    pthread_mutex_unlock(&padB_queue_mutex);
+                }
+                continue;
+            }
+            padB_working = TRUE;
+            padB_work_time = time(NULL) - (service_time * 1000 - remaining) / 1000;
+            padB_work_job = job.type;
+            padB_work_id = job.ID;
+            PublishPad(1, TRUE, job);
+            long service_start = TRACE_NOW();
+            remaining = PadWait(&padB_work_mutex, &padB_preempt_cond, &padB_preempt, &padB_deadline, remaining);
+            if (remaining > 0) {
+                padB_working = FALSE;
+                PublishPad(1, FALSE, job);
+            }
+            pthread_mutex_unlock(&padB_work_mutex);
+            TRACE_COMPLETE(remaining > 0 ? "preempted" : TraceJobName(job.type), "pad", service_start, job.ID, job.type);
+
+            if (remaining > 0) {
+                // the emergency is now at the head, the job resumes right after it
+                job.started = TRUE;
+                job.remaining = remaining;
+                job.interrupted = TRUE;
+                job.interrupted_at = Now_ms();
+                pthread_mutex_lock(&padB_queue_mutex);
+                UpdateJob(padB_queue, job);
+                pthread_mutex_unlock(&padB_queue_mutex);
+                continue;
+            }
             job.end_time = time(NULL);
-            
+
             pthread_mutex_lock(&padB_queue_mutex);
-            Dequeue(padB_queue);
+            RemoveJob(padB_queue, job.ID);
+            PublishQueue(METRICS_PADB, padB_queue);
             pthread_mutex_unlock(&padB_queue_mutex);
 
             pthread_mutex_lock(&padB_work_mutex);
             padB_working = FALSE;
+            padB_preempt = FALSE;
+            PublishPad(1, FALSE, job);
             pthread_mutex_unlock(&padB_work_mutex);
 
             KeepLog(job);
@@ -364,26 +644,56 @@ void* PadB(void *arg) {
 
 // the function that controls the air traffic
 void* ControlTower(void *arg)  {
+    TRACE_THREAD("ControlTower");
     while (end_time > time(NULL)) {
 
+        long lock_start = TRACE_NOW();
         pthread_mutex_lock(&emergency_queue_mutex);
+        long hold_start = TRACE_NOW();
+        int dispatched = 0;
         while (!isEmpty(emergency_queue)) {
             pthread_mutex_lock(&padA_queue_mutex);
             pthread_mutex_lock(&padB_queue_mutex);
             pthread_mutex_lock(&padA_work_mutex);
             pthread_mutex_lock(&padB_work_mutex);
-            if(!padA_working) {
+            if(isFull(padA_queue) && isFull(padB_queue)) {
+                // no room on either pad, emergencies wait in their queue
+                PublishQueue(METRICS_PADA, padA_queue);
+                pthread_mutex_unlock(&padA_queue_mutex);
+                PublishQueue(METRICS_PADB, padB_queue);
+                pthread_mutex_unlock(&padB_queue_mutex);
+                pthread_mutex_unlock(&padA_work_mutex);
+                pthread_mutex_unlock(&padB_work_mutex);
+                break;
+            }
+            TRACE_INSTANT("emergency dispatch", "tower", emergency_queue->head->data.ID, 'E');
+            dispatched++;
+            if(!padA_working && !isFull(padA_queue)) {
                 Job job = Dequeue(emergency_queue);
                 job.pad = 'A';
                 EnqueueFirst(padA_queue, job);
-            } else if(!padB_working) {
+                WakePad(&padA_preempt_cond, &padA_reread);
+            } else if(!padB_working && !isFull(padB_queue)) {
+                Job job = Dequeue(emergency_queue);
+                job.pad = 'B';
+                EnqueueFirst(padB_queue, job);
+                WakePad(&padB_preempt_cond, &padB_reread);
+            } else if(preemption && padA_working && padA_work_job != 'E' && !padA_preempt && !isFull(padA_queue)) {
                 Job job = Dequeue(emergency_queue);
                 job.pad = 'A';
                 EnqueueFirst(padA_queue, job);
+                padA_preempt = TRUE;
+                pthread_cond_signal(&padA_preempt_cond);
+            } else if(preemption && padB_working && padB_work_job != 'E' && !padB_preempt && !isFull(padB_queue)) {
+                Job job = Dequeue(emergency_queue);
+                job.pad = 'B';
+                EnqueueFirst(padB_queue, job);
+                padB_preempt = TRUE;
+                pthread_cond_signal(&padB_preempt_cond);
             } else {
-                int padA_remaining_time = FindPadARemainingTime();
-                int padB_remaining_time = FindPadBRemainingTime();
-                if(padA_remaining_time >= padB_remaining_time) {
+                int padA_remaining_time = padA_working ? FindPadARemainingTime() : 0;
+                int padB_remaining_time = padB_working ? FindPadBRemainingTime() : 0;
+                if(isFull(padA_queue) || (padA_remaining_time >= padB_remaining_time && !isFull(padB_queue))) {
                     Job job = Dequeue(emergency_queue);
                     job.pad = 'B';
                     EnqueueSecond(padB_queue, job);
@@ -393,223 +703,602 @@ void* ControlTower(void *arg)  {
                     EnqueueSecond(padA_queue, job);
                 }
             }
+            PublishQueue(METRICS_PADA, padA_queue);
             pthread_mutex_unlock(&padA_queue_mutex);
+            PublishQueue(METRICS_PADB, padB_queue);
             pthread_mutex_unlock(&padB_queue_mutex);
             pthread_mutex_unlock(&padA_work_mutex);
             pthread_mutex_unlock(&padB_work_mutex);
         }
+        Refill(emergency_queue, &emergency_overflow);
         pthread_mutex_unlock(&emergency_queue_mutex);
-
-
-
-        pthread_mutex_lock(&land_queue_mutex);
-        if (!isEmpty(land_queue) && (launch_queue->size < 3) && (assembly_queue->size < 3)) {
-            pthread_mutex_lock(&padA_queue_mutex);
-            pthread_mutex_lock(&padB_queue_mutex);
-
-            NODE *currentA = padA_queue->head;
-            int padA_sum = 0;
-            while (currentA != NULL) {
-                if (currentA->data.type == 'D') {
-                    padA_sum += 2*t;
-                } else {
-                    padA_sum += 1*t;
-                }
-
-                currentA = currentA->prev;
-            }
-
-            NODE *currentB = padB_queue->head;
-            int padB_sum = 0;
-            while (currentB != NULL) {
-                if (currentB->data.type == 'A') {
-                    padB_sum += 6*t;
-                } else {
-                    padB_sum += 1*t;
-                }
-
-                currentB = currentB->prev;
-            }
-
-            if (padA_sum >= padB_sum) {
-                Job job = Dequeue(land_queue);
-                job.pad = 'B';
-                Enqueue(padB_queue, job);
-            } else {
-                Job job = Dequeue(land_queue);
-                job.pad = 'A';
-                Enqueue(padA_queue, job);
-            }
-
-            pthread_mutex_unlock(&padA_queue_mutex);
-            pthread_mutex_unlock(&padB_queue_mutex);
+        if (tracing && hold_start - lock_start >= TRACE_STALL_US) {
+            TRACE_SPAN("wait emergency lock", "lock", lock_start, hold_start, 0, 0);
         }
-        pthread_mutex_unlock(&land_queue_mutex);
-        
-        pthread_mutex_lock(&launch_queue_mutex);
-        pthread_mutex_lock(&padA_queue_mutex);
-        if (isEmpty(padA_queue) && !isEmpty(launch_queue) || launch_queue->size >= 3) {
-            Job job = Dequeue(launch_queue);
-            job.pad = 'A';
-            Enqueue(padA_queue, job);
+        if (tracing && dispatched > 0) {
+            TRACE_COMPLETE("hold emergency and pad locks", "lock", hold_start, 0, 0);
         }
-        pthread_mutex_unlock(&padA_queue_mutex);
-        pthread_mutex_unlock(&launch_queue_mutex);
 
+        lock_start = TRACE_NOW();
+        pthread_mutex_lock(&land_queue_mutex);
+        pthread_mutex_lock(&launch_queue_mutex);
         pthread_mutex_lock(&assembly_queue_mutex);
+        pthread_mutex_lock(&padA_queue_mutex);
         pthread_mutex_lock(&padB_queue_mutex);
-        if (isEmpty(padB_queue) && !isEmpty(assembly_queue) || assembly_queue->size >= 3) {
-            Job job = Dequeue(assembly_queue);
-            job.pad = 'B';
-            Enqueue(padB_queue, job);
+
+        pthread_mutex_lock(&padA_work_mutex);
+        pthread_mutex_lock(&padB_work_mutex);
+        TowerState state = {
+            .land = land_queue,
+            .launch = launch_queue,
+            .assembly = assembly_queue,
+            .padA = padA_queue,
+            .padB = padB_queue,
+            .padA_job = padA_working ? padA_work_id : 0,
+            .padB_job = padB_working ? padB_work_id : 0,
+            .padA_remaining = padA_working ? (Remaining_ms(&padA_deadline) + 999) / 1000 : 0,
+            .padB_remaining = padB_working ? (Remaining_ms(&padB_deadline) + 999) / 1000 : 0,
+            .now = time(NULL) - start_time
+        };
+        pthread_mutex_unlock(&padA_work_mutex);
+        pthread_mutex_unlock(&padB_work_mutex);
+        hold_start = TRACE_NOW();
+        int padA_before = padA_queue->size;
+        int padB_before = padB_queue->size;
+
+        int moved = policy->dispatch(&state);
+        if (tracing && moved > 0) {
+            TracePadEnqueues(padA_queue, padA_before, "enqueue padA");
+            TracePadEnqueues(padB_queue, padB_before, "enqueue padB");
         }
+
+        PublishQueue(METRICS_PADA, padA_queue);
+        PublishQueue(METRICS_PADB, padB_queue);
+        pthread_mutex_unlock(&padA_queue_mutex);
         pthread_mutex_unlock(&padB_queue_mutex);
+        Refill(assembly_queue, &assembly_overflow);
         pthread_mutex_unlock(&assembly_queue_mutex);
+        Refill(launch_queue, &launch_overflow);
+        pthread_mutex_unlock(&launch_queue_mutex);
+        Refill(land_queue, &land_overflow);
+        pthread_mutex_unlock(&land_queue_mutex);
+        if (tracing && hold_start - lock_start >= TRACE_STALL_US) {
+            TRACE_SPAN("wait dispatch locks", "lock", lock_start, hold_start, 0, 0);
+        }
+        if (tracing && moved > 0) {
+            TRACE_COMPLETE(policy->name, "tower", hold_start, 0, 0);
+        }
+    }
+}
 
+// records the jobs a policy appended behind the first `before` jobs of a pad queue
+void TracePadEnqueues(Queue *pad, int before, const char *name) {
+    NODE *current = pad->head;
+    for (int i = 0; current != NULL; i++, current = current->prev) {
+        if (i >= before) {
+            TRACE_INSTANT(name, "tower", current->data.ID, current->data.type);
+        }
     }
 }
 
 
 void* Print_Jobs_Terminal(void *arg)  {
+    TRACE_THREAD("Print_Jobs_Terminal");
     while(time(NULL) < (start_time + n));
     int printTime = n;
+    if (time(NULL) - start_time > n) {
+        // resumed from a checkpoint, the clock is already past n
+        printTime = time(NULL) - start_time;
+    }
     while(time(NULL) < end_time) {
-        int landingJobsIDArray[100];
-        int totalLands = 0;
-        int launchingJobsIDArray[100];
-        int totalLaunchs = 0;
-        int assemblyJobsIDArray[100];
-        int totalAssemblies = 0;
-        int emergencyJobsIDArray[100];
-        int totalEmergencies = 0;
-        int padAJobsIDArray[100];
-        char padAJobsTypeArray[100];
-        int totalPadA = 0;
-        int padBJobsIDArray[100];
-        char padBJobsTypeArray[100];
-        int totalPadB = 0;
-        pthread_mutex_lock(&padA_queue_mutex);
-        NODE *currentA = padA_queue->head;
-        while (currentA != NULL) {
-            padAJobsIDArray[totalPadA] = currentA->data.ID;
-            padAJobsTypeArray[totalPadA] = currentA->data.type;
-            totalPadA++;
-            if (currentA->data.type == 'D') {
-                launchingJobsIDArray[totalLaunchs] = currentA->data.ID;
-                totalLaunchs++;
-            } else if (currentA->data.type == 'L') {
-                landingJobsIDArray[totalLands] = currentA->data.ID;
-                totalLands++;
-            } else if (currentA->data.type == 'E') {
-                emergencyJobsIDArray[totalEmergencies] = currentA->data.ID;
-                totalEmergencies++;
-            }
-            currentA = currentA->prev;
-        }
-        pthread_mutex_unlock(&padA_queue_mutex);
-        
-        pthread_mutex_lock(&padB_queue_mutex);
-        NODE *currentB = padB_queue->head;
-        while (currentB != NULL) {
-            padBJobsIDArray[totalPadB] = currentB->data.ID;
-            padBJobsTypeArray[totalPadB] = currentB->data.type;
-            totalPadB++;
-            if (currentB->data.type == 'A') {
-                assemblyJobsIDArray[totalAssemblies] = currentB->data.ID;
-                totalAssemblies++;
-            } else if (currentB->data.type == 'L') {
-                landingJobsIDArray[totalLands] = currentB->data.ID;
-                totalLands++;
-            } else if (currentB->data.type == 'E') {
-                emergencyJobsIDArray[totalEmergencies] = currentB->data.ID;
-                totalEmergencies++;
-            }
-            currentB = currentB->prev;
-        }
-        pthread_mutex_unlock(&padB_queue_mutex);
-
-        pthread_mutex_lock(&land_queue_mutex);
-        NODE *currentLand = land_queue->head;
-        while (currentLand != NULL) {
-            landingJobsIDArray[totalLands] = currentLand->data.ID;
-            totalLands++;
-            currentLand = currentLand->prev;
-        }
-        pthread_mutex_unlock(&land_queue_mutex);
-
-        pthread_mutex_lock(&launch_queue_mutex);
-        NODE *currentLaunch = launch_queue->head;
-        while (currentLaunch != NULL) {
-            launchingJobsIDArray[totalLaunchs] = currentLaunch->data.ID;
-            totalLaunchs++;
-            currentLaunch = currentLaunch->prev;
-        }
-        pthread_mutex_unlock(&launch_queue_mutex);
-
-        pthread_mutex_lock(&assembly_queue_mutex);
-        NODE *currentAssembly = assembly_queue->head;
-        while (currentAssembly != NULL) {
-            assemblyJobsIDArray[totalAssemblies] = currentAssembly->data.ID;
-            totalAssemblies++;
-            currentAssembly = currentAssembly->prev;
-        }
-        pthread_mutex_unlock(&assembly_queue_mutex);
-
-        pthread_mutex_lock(&emergency_queue_mutex);
-        NODE *currentEmergency = emergency_queue->head;
-        while (currentEmergency != NULL) {
-            emergencyJobsIDArray[totalEmergencies] = currentEmergency->data.ID;
-            totalEmergencies++;
-            currentEmergency = currentEmergency->prev;
-        }
-        pthread_mutex_unlock(&emergency_queue_mutex);
-
+        // every queue is printed while it is walked, so a line is as long as the queues are
         printf("At %d sec landing    : ",printTime);
-        for(int i = 0; i < totalLands; i++) {
-            printf("%d ",landingJobsIDArray[i]);
-        }
+        Print_Queue_IDs(padA_queue, &padA_queue_mutex, 'L', FALSE);
+        Print_Queue_IDs(padB_queue, &padB_queue_mutex, 'L', FALSE);
+        Print_Queue_IDs(land_queue, &land_queue_mutex, 0, FALSE);
         printf("\n");
 
         printf("At %d sec launch     : ",printTime);
-        for(int i = 0; i < totalLaunchs; i++) {
-            printf("%d ",launchingJobsIDArray[i]);
-        }
+        Print_Queue_IDs(padA_queue, &padA_queue_mutex, 'D', FALSE);
+        Print_Queue_IDs(launch_queue, &launch_queue_mutex, 0, FALSE);
         printf("\n");
 
         printf("At %d sec assembly   : ",printTime);
-        for(int i = 0; i < totalAssemblies; i++) {
-            printf("%d ",assemblyJobsIDArray[i]);
-        }
+        Print_Queue_IDs(padB_queue, &padB_queue_mutex, 'A', FALSE);
+        Print_Queue_IDs(assembly_queue, &assembly_queue_mutex, 0, FALSE);
         printf("\n");
 
         printf("At %d sec emergency  : ",printTime);
-        for(int i = 0; i < totalEmergencies; i++) {
-            printf("%d ",emergencyJobsIDArray[i]);
-        }
+        Print_Queue_IDs(padA_queue, &padA_queue_mutex, 'E', FALSE);
+        Print_Queue_IDs(padB_queue, &padB_queue_mutex, 'E', FALSE);
+        Print_Queue_IDs(emergency_queue, &emergency_queue_mutex, 0, FALSE);
         printf("\n");
 
         printf("At %d sec padA       : ",printTime);
-        for(int i = 0; i < totalPadA; i++) {
-            printf("%d(%c) ",padAJobsIDArray[i],padAJobsTypeArray[i]);
-        }
+        Print_Queue_IDs(padA_queue, &padA_queue_mutex, 0, TRUE);
         printf("\n");
 
         printf("At %d sec padB       : ",printTime);
-        for(int i = 0; i < totalPadB; i++) {
-            printf("%d(%c) ",padBJobsIDArray[i],padBJobsTypeArray[i]);
-        }
+        Print_Queue_IDs(padB_queue, &padB_queue_mutex, 0, TRUE);
         printf("\n\n");
         printTime++;
         pthread_sleep(1);
     }
 }
 
+// prints the IDs of a queue's jobs of one type, or of every job when type is 0
+void Print_Queue_IDs(Queue *queue, pthread_mutex_t *mutex, char type, bool with_type) {
+    pthread_mutex_lock(mutex);
+    NODE *current = queue->head;
+    while (current != NULL) {
+        if (type == 0 || current->data.type == type) {
+            if (with_type) {
+                printf("%d(%c) ",current->data.ID,current->data.type);
+            } else {
+                printf("%d ",current->data.ID);
+            }
+        }
+        current = current->prev;
+    }
+    pthread_mutex_unlock(mutex);
+}
+
 void* KeepLog(Job job) {
+    long log_start = TRACE_NOW();
     pthread_mutex_lock(&file_mutex);
     job_log = fopen(file_name,"a");
-    fprintf(job_log,"%-9d%-8c%-14ld%-10ld%-17d%c\n",job.ID,job.type,job.request_time-start_time,job.end_time-start_time,job.end_time-job.request_time,job.pad);
+    if (preemption) {
+        fprintf(job_log,"%-9d%-8c%-14ld%-10ld%-17d%-5c%.3f\n",job.ID,job.type,job.request_time-start_time,job.end_time-start_time,job.end_time-job.request_time,job.pad,job.preempted/1000.0);
+    } else {
+        fprintf(job_log,"%-9d%-8c%-14ld%-10ld%-17d%c\n",job.ID,job.type,job.request_time-start_time,job.end_time-start_time,job.end_time-job.request_time,job.pad);
+    }
     fclose(job_log);
     pthread_mutex_unlock(&file_mutex);
+    TRACE_COMPLETE("KeepLog", "log", log_start, job.ID, job.type);
+
+    PublishCompletion(job);
+}
+
+// admits a generated job into its waiting queue according to the queue's overload policy
+void Admit(Queue *queue, pthread_mutex_t *mutex, Overflow *overflow, Job job) {
+    pthread_mutex_lock(mutex);
+    long rejected = overflow->rejected;
+    if (overflow->policy == OVERLOAD_SPILL && overflow->spill_size > 0) {
+        // older jobs are still on disk, keep the arrival order
+        Spill(overflow, job);
+        TRACE_INSTANT("spill", "generator", job.ID, job.type);
+    } else if (Enqueue(queue, job)) {
+        overflow->admitted++;
+        TRACE_INSTANT("enqueue", "generator", job.ID, job.type);
+    } else if (overflow->policy == OVERLOAD_BLOCK) {
+        overflow->delayed++;
+        long block_start = TRACE_NOW();
+        struct timespec timetoexpire = { .tv_sec = end_time, .tv_nsec = 0 };
+        while (isFull(queue) && end_time > time(NULL)) {
+            pthread_cond_timedwait(&overflow->not_full, mutex, &timetoexpire);
+        }
+        if (Enqueue(queue, job)) {
+            overflow->admitted++;
+        } else {
+            overflow->rejected++;
+        }
+        TRACE_COMPLETE("blocked", "generator", block_start, job.ID, job.type);
+    } else if (overflow->policy == OVERLOAD_SPILL) {
+        Spill(overflow, job);
+        TRACE_INSTANT("spill", "generator", job.ID, job.type);
+    } else {
+        overflow->rejected++;
+    }
+    if (overflow->rejected != rejected) {
+        TRACE_INSTANT("reject", "generator", job.ID, job.type);
+    }
+    PublishQueue(overflow->index, queue);
+    PublishRejected(job.type, overflow->rejected - rejected);
+    pthread_mutex_unlock(mutex);
+}
+
+// appends a job to the overflow file, caller holds the queue's mutex
+void Spill(Overflow *overflow, Job job) {
+    if (overflow->spill == NULL) {
+        overflow->spill = tmpfile();
+    }
+    if (overflow->spill == NULL || fseek(overflow->spill, 0, SEEK_END) != 0 ||
+        fwrite(&job, sizeof(Job), 1, overflow->spill) != 1) {
+        overflow->rejected++;
+        return;
+    }
+    overflow->spill_size++;
+    overflow->spilled++;
+}
+
+// moves spilled jobs back into the queue and wakes blocked generators,
+// caller holds the queue's mutex
+void Refill(Queue *queue, Overflow *overflow) {
+    while (overflow->spill_size > 0 && !isFull(queue)) {
+        Job job;
+        fseek(overflow->spill, overflow->spill_head * sizeof(Job), SEEK_SET);
+        if (fread(&job, sizeof(Job), 1, overflow->spill) != 1) {
+            break;
+        }
+        Enqueue(queue, job);
+        overflow->spill_head++;
+        overflow->spill_size--;
+        overflow->admitted++;
+    }
+    if (overflow->spill != NULL && overflow->spill_size == 0 && overflow->spill_head > 0) {
+        // everything was read back, reuse the file from the beginning
+        fflush(overflow->spill);
+        ftruncate(fileno(overflow->spill), 0);
+        overflow->spill_head = 0;
+    }
+    if (!isFull(queue)) {
+        pthread_cond_signal(&overflow->not_full);
+    }
+    PublishQueue(overflow->index, queue);
+}
+
+void Print_Admission_Report() {
+    char *overload_names[] = { "block", "shed", "spill" };
+    char *names[] = { "landing", "launch", "assembly", "emergency" };
+    Overflow *overflows[] = { &land_overflow, &launch_overflow, &assembly_overflow, &emergency_overflow };
+    printf("Admission (capacity %d, overload policy %s)\n", land_queue->limit, overload_names[overloadPolicy]);
+    printf("%-11s%-10s%-10s%-9s%-9s%s\n", "Queue", "Admitted", "Rejected", "Delayed", "Spilled", "On_Disk");
+    for(int i = 0; i < 4; i++) {
+        printf("%-11s%-10ld%-10ld%-9ld%-9ld%ld\n", names[i], overflows[i]->admitted, overflows[i]->rejected,
+            overflows[i]->delayed, overflows[i]->spilled, overflows[i]->spill_size);
+    }
+}
+
+// takes a checkpoint once the simulated clock reaches checkpointTime
+void* CheckpointJob(void *arg) {
+    TRACE_THREAD("CheckpointJob");
+    time_t checkpoint_at = start_time + (checkpointTime >= 0 ? checkpointTime : simulationTime);
+    while (checkpoint_at > time(NULL) && end_time > time(NULL)) {
+        pthread_sleep(1);
+    }
+    if (WriteCheckpoint(checkpoint_file) != 0) {
+        fprintf(stderr, "cannot write checkpoint %s\n", checkpoint_file);
+    }
+}
+
+// writes the jobs of a queue followed by its spilled jobs, times relative to start_time;
+// the job in service on a pad is stored with the service time it has left
+void WriteQueueJobs(FILE *image, Queue *queue, Overflow *overflow, int working_id, int remaining) {
+    NODE *current = queue->head;
+    while (current != NULL) {
+        Job job = current->data;
+        if (job.ID == working_id) {
+            // a job that finished but is not removed yet is restored with nothing left
+            job.started = TRUE;
+            job.remaining = remaining;
+        }
+        job.request_time -= start_time;
+        fwrite(&job, sizeof(Job), 1, image);
+        current = current->prev;
+    }
+    if (overflow == NULL || overflow->spill_size == 0) {
+        return;
+    }
+    fseek(overflow->spill, overflow->spill_head * sizeof(Job), SEEK_SET);
+    for (long i = 0; i < overflow->spill_size; i++) {
+        Job job;
+        if (fread(&job, sizeof(Job), 1, overflow->spill) != 1) {
+            break;
+        }
+        job.request_time -= start_time;
+        fwrite(&job, sizeof(Job), 1, image);
+    }
+}
+
+// serializes the whole simulation state into a compact binary image,
+// every lock is taken in the same order the other threads use them
+int WriteCheckpoint(char *path) {
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *image = fopen(tmp_path, "wb");
+    if (image == NULL) {
+        return -1;
+    }
+    setvbuf(image, NULL, _IOFBF, 1 << 20);
+
+    pthread_mutex_lock(&ID_mutex);
+    pthread_mutex_lock(&emergency_queue_mutex);
+    pthread_mutex_lock(&land_queue_mutex);
+    pthread_mutex_lock(&launch_queue_mutex);
+    pthread_mutex_lock(&assembly_queue_mutex);
+    pthread_mutex_lock(&padA_queue_mutex);
+    pthread_mutex_lock(&padB_queue_mutex);
+    pthread_mutex_lock(&padA_work_mutex);
+    pthread_mutex_lock(&padB_work_mutex);
+    pthread_mutex_lock(&rng_mutex);
+
+    Checkpoint header = {
+        .magic = CHECKPOINT_MAGIC,
+        .version = CHECKPOINT_VERSION,
+        .elapsed = time(NULL) - start_time,
+        .ID = ID,
+        .rng_state = rng_state,
+        .emergency_counter = emergency_counter,
+        .pad_working = { padA_working, padB_working },
+        .pad_work_time = { padA_work_time - start_time, padB_work_time - start_time },
+        .pad_work_job = { padA_work_job, padB_work_job },
+        .queue_size = {
+            launch_queue->size + launch_overflow.spill_size,
+            land_queue->size + land_overflow.spill_size,
+            assembly_queue->size + assembly_overflow.spill_size,
+            emergency_queue->size + emergency_overflow.spill_size,
+            padA_queue->size,
+            padB_queue->size
+        }
+    };
+    Overflow *overflows[] = { &launch_overflow, &land_overflow, &assembly_overflow, &emergency_overflow };
+    for (int i = 0; i < 4; i++) {
+        header.admitted[i] = overflows[i]->admitted;
+        header.rejected[i] = overflows[i]->rejected;
+        header.delayed[i] = overflows[i]->delayed;
+        header.spilled[i] = overflows[i]->spilled;
+    }
+    fwrite(&header, sizeof(Checkpoint), 1, image);
+    WriteQueueJobs(image, launch_queue, &launch_overflow, 0, 0);
+    WriteQueueJobs(image, land_queue, &land_overflow, 0, 0);
+    WriteQueueJobs(image, assembly_queue, &assembly_overflow, 0, 0);
+    WriteQueueJobs(image, emergency_queue, &emergency_overflow, 0, 0);
+    WriteQueueJobs(image, padA_queue, NULL, padA_working ? padA_work_id : 0, Remaining_ms(&padA_deadline));
+    WriteQueueJobs(image, padB_queue, NULL, padB_working ? padB_work_id : 0, Remaining_ms(&padB_deadline));
+
+    pthread_mutex_unlock(&rng_mutex);
+    pthread_mutex_unlock(&padB_work_mutex);
+    pthread_mutex_unlock(&padA_work_mutex);
+    pthread_mutex_unlock(&padB_queue_mutex);
+    pthread_mutex_unlock(&padA_queue_mutex);
+    pthread_mutex_unlock(&assembly_queue_mutex);
+    pthread_mutex_unlock(&launch_queue_mutex);
+    pthread_mutex_unlock(&land_queue_mutex);
+    pthread_mutex_unlock(&emergency_queue_mutex);
+    pthread_mutex_unlock(&ID_mutex);
+
+    if (fclose(image) != 0) {
+        return -1;
+    }
+    // the old image stays valid until the new one is complete
+    if (rename(tmp_path, path) != 0) {
+        return -1;
+    }
+    printf("Checkpoint at %d sec written to %s\n", header.elapsed, path);
+    return 0;
+}
+
+// rebuilds a queue from checkpoint records, jobs that no longer fit are spilled or rejected
+void RestoreQueueJobs(Queue *queue, Overflow *overflow, Job *jobs, int count) {
+    for (int i = 0; i < count; i++) {
+        Job job = jobs[i];
+        job.request_time += start_time;
+        if (Enqueue(queue, job)) {
+            continue;
+        }
+        if (overflow == NULL) {
+            fprintf(stderr, "pad queue is full, job %d is not restored\n", job.ID);
+        } else if (overflow->policy == OVERLOAD_SPILL) {
+            Spill(overflow, job);
+        } else {
+            overflow->rejected++;
+            PublishRejected(job.type, 1);
+        }
+    }
+}
+
+// memory-maps a checkpoint image and resumes the simulation from it,
+// called before any thread is started
+int RestoreCheckpoint(char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < sizeof(Checkpoint)) {
+        close(fd);
+        return -1;
+    }
+    char *image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        return -1;
+    }
+
+    Checkpoint *header = (Checkpoint*) image;
+    long total = 0;
+    for (int i = 0; i < 6; i++) {
+        if (header->queue_size[i] < 0) {
+            munmap(image, st.st_size);
+            return -1;
+        }
+        total += header->queue_size[i];
+    }
+    if (memcmp(header->magic, CHECKPOINT_MAGIC, 4) != 0 || header->version != CHECKPOINT_VERSION ||
+        st.st_size != sizeof(Checkpoint) + total * sizeof(Job)) {
+        munmap(image, st.st_size);
+        return -1;
+    }
+
+    // the simulated clock continues where the checkpoint was taken
+    start_time = time(NULL) - header->elapsed;
+    ID = header->ID;
+    rng_state = header->rng_state;
+    emergency_counter = header->emergency_counter;
+    // no pad is serving yet, a job that was in service resumes from its remaining time
+    padA_working = FALSE;
+    padB_working = FALSE;
+    padA_work_time = start_time + header->pad_work_time[0];
+    padB_work_time = start_time + header->pad_work_time[1];
+    padA_work_job = header->pad_work_job[0];
+    padB_work_job = header->pad_work_job[1];
+
+    Job *jobs = (Job*) (image + sizeof(Checkpoint));
+    Queue *queues[] = { launch_queue, land_queue, assembly_queue, emergency_queue, padA_queue, padB_queue };
+    Overflow *overflows[] = { &launch_overflow, &land_overflow, &assembly_overflow, &emergency_overflow, NULL, NULL };
+    for (int i = 0; i < 4; i++) {
+        overflows[i]->admitted = header->admitted[i];
+        overflows[i]->rejected = header->rejected[i];
+        overflows[i]->delayed = header->delayed[i];
+        overflows[i]->spilled = header->spilled[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        RestoreQueueJobs(queues[i], overflows[i], jobs, header->queue_size[i]);
+        jobs += header->queue_size[i];
+    }
+
+    printf("Restored %ld jobs at %d sec from %s\n", total, header->elapsed, path);
+    munmap(image, st.st_size);
+    return 0;
+}
+
+// creates the shared-memory segment external monitors attach to
+int OpenMetrics(char *name) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(Metrics)) != 0) {
+        close(fd);
+        return -1;
+    }
+    metrics = mmap(NULL, sizeof(Metrics), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (metrics == MAP_FAILED) {
+        metrics = NULL;
+        return -1;
+    }
+    memset(metrics, 0, sizeof(Metrics));
+    metrics->version = METRICS_VERSION;
+    metrics->running = TRUE;
+    __atomic_store_n(&metrics->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void CloseMetrics(char *name) {
+    __atomic_store_n(&metrics->clock, time(NULL) - start_time, __ATOMIC_RELAXED);
+    __atomic_store_n(&metrics->running, FALSE, __ATOMIC_RELEASE);
+    munmap(metrics, sizeof(Metrics));
+    metrics = NULL;
+    shm_unlink(name);
+}
+
+// caller holds the queue's mutex, nothing is written unless the depth changed
+void PublishQueue(int index, Queue *queue) {
+    if (metrics == NULL || __atomic_load_n(&metrics->queue_depth[index], __ATOMIC_RELAXED) == queue->size) {
+        return;
+    }
+    __atomic_store_n(&metrics->queue_depth[index], queue->size, __ATOMIC_RELAXED);
+}
+
+// seqlock writer side of a pad's section, only the pad's own thread writes
+// to it, so no writer lock is needed
+void MetricsPadBegin(MetricsPad *slot) {
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void MetricsPadEnd(MetricsPad *slot) {
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+}
+
+void PublishPad(int pad, bool busy, Job job) {
+    if (metrics == NULL) {
+        return;
+    }
+    MetricsPad *slot = &metrics->pad[pad];
+    MetricsPadBegin(slot);
+    __atomic_store_n(&slot->busy, busy, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->job_id, busy ? job.ID : 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->job_type, busy ? job.type : 0, __ATOMIC_RELAXED);
+    MetricsPadEnd(slot);
+}
+
+// called from KeepLog on the pad thread that finished the job
+void PublishCompletion(Job job) {
+    if (metrics == NULL) {
+        return;
+    }
+    MetricsPad *slot = &metrics->pad[job.pad == 'B' ? 1 : 0];
+    int type = MetricsType(job.type);
+    MetricsPadBegin(slot);
+    __atomic_store_n(&slot->completed[type], slot->completed[type] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->turnaround_sum[type], slot->turnaround_sum[type] + job.end_time - job.request_time, __ATOMIC_RELAXED);
+    MetricsPadEnd(slot);
+}
+
+void PublishRejected(char type, long rejected) {
+    if (metrics == NULL || rejected == 0) {
+        return;
+    }
+    __atomic_fetch_add(&metrics->rejected[MetricsType(type)], rejected, __ATOMIC_RELAXED);
+}
+
+// waits out a pad's service time unless the control tower preempts it, caller holds
+// the pad's work mutex; returns the milliseconds left when preempted, 0 when done
+int PadWait(pthread_mutex_t *work_mutex, pthread_cond_t *preempt_cond, bool *preempt, struct timespec *deadline, int service_ms) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += service_ms / 1000;
+    deadline->tv_nsec += (service_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+    // only a request made while this job is in service counts
+    *preempt = FALSE;
+    while (!*preempt) {
+        if (pthread_cond_timedwait(preempt_cond, work_mutex, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (!*preempt) {
+        return 0;
+    }
+    *preempt = FALSE;
+    return Remaining_ms(deadline);
+}
+
+// waits for work on an empty pad, an emergency wakes it up early
+void PadIdle(pthread_mutex_t *work_mutex, pthread_cond_t *preempt_cond, bool *reread) {
+    struct timespec timetoexpire;
+    clock_gettime(CLOCK_REALTIME, &timetoexpire);
+    timetoexpire.tv_sec += t;
+    pthread_mutex_lock(work_mutex);
+    if (!*reread) {
+        pthread_cond_timedwait(preempt_cond, work_mutex, &timetoexpire);
+    }
+    // the pad reads its head next anyway
+    *reread = FALSE;
+    pthread_mutex_unlock(work_mutex);
+}
+
+// an emergency went to the head of a pad that is not working, caller holds the pad's
+// work mutex; the flag only makes a pad that already picked another job but has not
+// started it go back to the head, a job in service is never interrupted by it
+void WakePad(pthread_cond_t *preempt_cond, bool *reread) {
+    if (!preemption) {
+        return;
+    }
+    *reread = TRUE;
+    pthread_cond_signal(preempt_cond);
+}
+
+// milliseconds until the deadline, rounded up so an unfinished job never reads as done
+int Remaining_ms(struct timespec *deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long remaining = (deadline->tv_sec - now.tv_sec) * 1000000000L + deadline->tv_nsec - now.tv_nsec;
+    if (remaining <= 0) {
+        return 0;
+    }
+    return (remaining + 999999) / 1000000;
+}
+
+// milliseconds since start_time
+int Now_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (now.tv_sec - start_time) * 1000 + now.tv_nsec / 1000000;
 }
 
 int FindPadARemainingTime() {
@@ -0,0 +1,77 @@
+#include <stdint.h>
+#include <string.h>
+
+/* layout of the live metrics segment the simulator publishes with -m */
+
+#define METRICS_NAME    "/spacecraft-metrics"
+#define METRICS_MAGIC   0x5343544d
+#define METRICS_VERSION 3
+
+/* queue slots */
+#define METRICS_LAUNCH    0
+#define METRICS_LAND      1
+#define METRICS_ASSEMBLY  2
+#define METRICS_EMERGENCY 3
+#define METRICS_PADA      4
+#define METRICS_PADB      5
+#define METRICS_QUEUES    6
+
+/* job type slots */
+#define METRICS_TYPES     4
+
+/* a pad's state and the jobs it completed, written by that pad's thread only
+   under its own seqlock, so a count and its turnaround sum always match */
+typedef struct {
+    uint64_t seq;                           // odd while the pad is updating
+    int32_t busy;
+    int32_t job_id;
+    int32_t job_type;
+    uint64_t completed[METRICS_TYPES];      // L, D, A, E
+    uint64_t turnaround_sum[METRICS_TYPES]; // seconds
+} __attribute__((aligned(64))) MetricsPad;
+
+/* every other field is a single word written atomically, the counters only grow */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t start_time;
+    int64_t clock;                          // seconds since start_time when the simulator finished
+    int32_t running;
+    int32_t queue_depth[METRICS_QUEUES];
+    uint64_t rejected[METRICS_TYPES];       // L, D, A, E
+    MetricsPad pad[2];
+} Metrics;
+
+static const char metrics_types[METRICS_TYPES] = { 'L', 'D', 'A', 'E' };
+
+static inline int MetricsType(char type) {
+    switch (type) {
+        case 'L': return 0;
+        case 'D': return 1;
+        case 'A': return 2;
+        default:  return 3;
+    }
+}
+
+// copies a snapshot, each pad's state is retried while that pad is mid-update
+static inline void MetricsRead(const Metrics *shared, Metrics *copy) {
+    memcpy(copy, (const void*) shared, sizeof(Metrics));
+    for (int i = 0; i < 2; i++) {
+        uint64_t before, after;
+        do {
+            before = __atomic_load_n(&shared->pad[i].seq, __ATOMIC_ACQUIRE);
+            memcpy(&copy->pad[i], (const void*) &shared->pad[i], sizeof(MetricsPad));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            after = __atomic_load_n(&shared->pad[i].seq, __ATOMIC_RELAXED);
+        } while ((before & 1) || before != after);
+    }
+}
+
+// completions of one type on both pads, from a snapshot
+static inline uint64_t MetricsCompleted(const Metrics *m, int type) {
+    return m->pad[0].completed[type] + m->pad[1].completed[type];
+}
+
+static inline uint64_t MetricsTurnaroundSum(const Metrics *m, int type) {
+    return m->pad[0].turnaround_sum[type] + m->pad[1].turnaround_sum[type];
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "metrics.h"
+
+/* attaches to the metrics segment of a running simulator (main -m <name>)
+   and displays or scrapes it without touching the simulator's threads */
+
+char *queue_names[METRICS_QUEUES] = { "launch", "landing", "assembly", "emergency", "padA", "padB" };
+
+// the simulator only stores the clock once it has finished
+long Clock(Metrics *m) {
+    if (m->start_time == 0) {
+        return 0;
+    }
+    return m->running ? (long) (time(NULL) - m->start_time) : (long) m->clock;
+}
+
+void Print_Metrics(Metrics *m) {
+    printf("\033[H\033[2J");
+    printf("At %ld sec %s\n\n", Clock(m), m->running ? "" : "(finished)");
+    printf("%-11s%s\n", "Queue", "Depth");
+    for(int i = 0; i < METRICS_QUEUES; i++) {
+        printf("%-11s%d\n", queue_names[i], m->queue_depth[i]);
+    }
+    printf("\n%-6s%-6s%s\n", "Pad", "Busy", "Job");
+    for(int i = 0; i < 2; i++) {
+        if (m->pad[i].busy) {
+            printf("%-6c%-6s%d(%c)\n", 'A' + i, "yes", m->pad[i].job_id, m->pad[i].job_type);
+        } else {
+            printf("%-6c%-6s-\n", 'A' + i, "no");
+        }
+    }
+    printf("\n%-8s%-11s%-10s%s\n", "Status", "Completed", "Rejected", "Avg_Turnaround");
+    for(int i = 0; i < METRICS_TYPES; i++) {
+        uint64_t completed = MetricsCompleted(m, i);
+        double average = completed ? (double) MetricsTurnaroundSum(m, i) / completed : 0;
+        printf("%-8c%-11lu%-10lu%.2f\n", metrics_types[i], completed, m->rejected[i], average);
+    }
+    fflush(stdout);
+}
+
+// one sample per line in the Prometheus text format
+void Scrape_Metrics(Metrics *m) {
+    printf("spacecraft_running %d\n", m->running);
+    printf("spacecraft_clock_seconds %ld\n", Clock(m));
+    for(int i = 0; i < METRICS_QUEUES; i++) {
+        printf("spacecraft_queue_depth{queue=\"%s\"} %d\n", queue_names[i], m->queue_depth[i]);
+    }
+    for(int i = 0; i < 2; i++) {
+        printf("spacecraft_pad_busy{pad=\"%c\"} %d\n", 'A' + i, m->pad[i].busy);
+        printf("spacecraft_pad_job_id{pad=\"%c\"} %d\n", 'A' + i, m->pad[i].job_id);
+    }
+    for(int i = 0; i < METRICS_TYPES; i++) {
+        printf("spacecraft_completed_total{type=\"%c\"} %lu\n", metrics_types[i], MetricsCompleted(m, i));
+        printf("spacecraft_turnaround_seconds_sum{type=\"%c\"} %lu\n", metrics_types[i], MetricsTurnaroundSum(m, i));
+        printf("spacecraft_rejected_total{type=\"%c\"} %lu\n", metrics_types[i], m->rejected[i]);
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    // -m (name) => segment name, must match the simulator's -m
+    // -i (int) => refresh interval in milliseconds
+    // -once => print a single snapshot and exit
+    // -scrape => Prometheus text format instead of the table
+    char *name = METRICS_NAME;
+    int interval = 1000;
+    bool once = false;
+    bool scrape = false;
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-m")) {name = argv[++i];}
+        else if(!strcmp(argv[i], "-i")) {interval = atoi(argv[++i]);}
+        else if(!strcmp(argv[i], "-once")) {once = true;}
+        else if(!strcmp(argv[i], "-scrape")) {scrape = true;}
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "no metrics segment %s, is the simulator running with -m?\n", name);
+        return 1;
+    }
+    Metrics *shared = mmap(NULL, sizeof(Metrics), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    if (__atomic_load_n(&shared->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC || shared->version != METRICS_VERSION) {
+        fprintf(stderr, "%s is not a version %d metrics segment\n", name, METRICS_VERSION);
+        return 1;
+    }
+
+    Metrics snapshot;
+    do {
+        MetricsRead(shared, &snapshot);
+        if (scrape) {
+            Scrape_Metrics(&snapshot);
+        } else {
+            Print_Metrics(&snapshot);
+        }
+        if (once || !snapshot.running) {
+            break;
+        }
+        usleep(interval * 1000);
+    } while (true);
+
+    munmap(shared, sizeof(Metrics));
+    return 0;
+}
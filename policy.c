@@ -0,0 +1,219 @@
+/* scheduling policies of the control tower; a policy moves waiting landing, launch
+   and assembly jobs into the pad queues, emergencies are always handled by the tower.
+   Expects queue.c and the t constant to be defined by the including file. */
+
+/* what a policy sees, the caller holds every queue's mutex while it runs */
+typedef struct {
+    Queue *land;
+    Queue *launch;
+    Queue *assembly;
+    Queue *padA;
+    Queue *padB;
+    int padA_job;        // ID of the job in service on pad A, 0 when idle
+    int padB_job;
+    int padA_remaining;  // seconds left of the job in service on pad A, 0 when idle
+    int padB_remaining;
+    long now;            // seconds since the simulation started
+} TowerState;
+
+typedef struct {
+    char *name;
+    void (*reset)(void);                 // clears policy state between runs, may be NULL
+    int (*dispatch)(TowerState *state);  // returns how many jobs were moved
+} Policy;
+
+int ServiceTime(char type) {
+    if (type == 'D') {
+        return 2*t;
+    } else if (type == 'A') {
+        return 6*t;
+    } else {
+        return 1*t;
+    }
+}
+
+// pad queue slots only the control tower's emergencies may use
+#define EMERGENCY_ROOM 2
+
+bool PadFull(Queue *pad) {
+    return pad->size >= pad->limit - EMERGENCY_ROOM;
+}
+
+// seconds until a pad has finished everything queued on it; the job in service
+// is found by ID, an emergency may have been put in front of it
+int PadForecast(Queue *pad, int job, int remaining) {
+    int sum = 0;
+    NODE *current = pad->head;
+    while (current != NULL) {
+        sum += ServiceTime(current->data.type);
+        if (current->data.ID == job && remaining > 0) {
+            // only what is left of it counts
+            sum -= ServiceTime(current->data.type) - remaining;
+        }
+        current = current->prev;
+    }
+    return sum;
+}
+
+void Assign(Queue *from, Queue *pad, char name) {
+    Job job = Dequeue(from);
+    job.pad = name;
+    Enqueue(pad, job);
+}
+
+// the original control tower rules: landings go to the less loaded pad unless
+// launches or assemblies are piling up, which are forced once three are waiting
+int DefaultDispatch(TowerState *s) {
+    int moved = 0;
+    if (!isEmpty(s->land) && (s->launch->size < 3) && (s->assembly->size < 3) && !(PadFull(s->padA) && PadFull(s->padB))) {
+        int padA_sum = PadForecast(s->padA, 0, 0);
+        int padB_sum = PadForecast(s->padB, 0, 0);
+        if ((padA_sum >= padB_sum && !PadFull(s->padB)) || PadFull(s->padA)) {
+            Assign(s->land, s->padB, 'B');
+        } else {
+            Assign(s->land, s->padA, 'A');
+        }
+        moved++;
+    }
+    if (((isEmpty(s->padA) && !isEmpty(s->launch)) || s->launch->size >= 3) && !PadFull(s->padA)) {
+        Assign(s->launch, s->padA, 'A');
+        moved++;
+    }
+    if (((isEmpty(s->padB) && !isEmpty(s->assembly)) || s->assembly->size >= 3) && !PadFull(s->padB)) {
+        Assign(s->assembly, s->padB, 'B');
+        moved++;
+    }
+    return moved;
+}
+
+// shortest expected completion: of all waiting heads, dispatch the one that would
+// finish first, once its pad is about to free up or three jobs of its kind are waiting
+int ShortestCompletionDispatch(TowerState *s) {
+    int forecastA = PadForecast(s->padA, s->padA_job, s->padA_remaining);
+    int forecastB = PadForecast(s->padB, s->padB_job, s->padB_remaining);
+    Queue *from = NULL;
+    Queue *pad = NULL;
+    int best = 0;
+    int pad_forecast = 0;
+
+    if (!isEmpty(s->land) && !PadFull(s->padA) && (from == NULL || forecastA + 1*t < best)) {
+        from = s->land; pad = s->padA; best = forecastA + 1*t; pad_forecast = forecastA;
+    }
+    if (!isEmpty(s->land) && !PadFull(s->padB) && (from == NULL || forecastB + 1*t <= best)) {
+        from = s->land; pad = s->padB; best = forecastB + 1*t; pad_forecast = forecastB;
+    }
+    if (!isEmpty(s->launch) && !PadFull(s->padA) && (from == NULL || forecastA + 2*t < best)) {
+        from = s->launch; pad = s->padA; best = forecastA + 2*t; pad_forecast = forecastA;
+    }
+    if (!isEmpty(s->assembly) && !PadFull(s->padB) && (from == NULL || forecastB + 6*t < best)) {
+        from = s->assembly; pad = s->padB; best = forecastB + 6*t; pad_forecast = forecastB;
+    }
+    if (from == NULL || (pad_forecast > 1*t && from->size < 3)) {
+        return 0;
+    }
+    Assign(from, pad, pad == s->padA ? 'A' : 'B');
+    return 1;
+}
+
+/* weighted fair queueing by job type, self-clocked: every head gets a finish tag
+   of max(virtual time, last tag of its type) + service / weight */
+double wfq_weight[3] = { 2, 1, 1 };  // landing, launch, assembly
+double wfq_finish[3];
+double wfq_virtual;
+
+void WeightedFairReset() {
+    wfq_finish[0] = wfq_finish[1] = wfq_finish[2] = 0;
+    wfq_virtual = 0;
+}
+
+int WeightedFairDispatch(TowerState *s) {
+    int forecastA = PadForecast(s->padA, s->padA_job, s->padA_remaining);
+    int forecastB = PadForecast(s->padB, s->padB_job, s->padB_remaining);
+    Queue *sources[3] = { s->land, s->launch, s->assembly };
+    int best = -1;
+    double best_tag = 0;
+    for (int i = 0; i < 3; i++) {
+        if (isEmpty(sources[i])) {
+            continue;
+        }
+        // jobs are only released to a pad that is about to free up
+        bool ready = (i != 2 && forecastA <= 1*t && !PadFull(s->padA)) ||
+                     (i != 1 && forecastB <= 1*t && !PadFull(s->padB));
+        if (!ready) {
+            continue;
+        }
+        double start = wfq_finish[i] > wfq_virtual ? wfq_finish[i] : wfq_virtual;
+        double tag = start + ServiceTime(sources[i]->head->data.type) / wfq_weight[i];
+        if (best < 0 || tag < best_tag) {
+            best = i;
+            best_tag = tag;
+        }
+    }
+    if (best < 0) {
+        return 0;
+    }
+    wfq_finish[best] = best_tag;
+    wfq_virtual = best_tag;
+    if (best == 1) {
+        Assign(s->launch, s->padA, 'A');
+    } else if (best == 2) {
+        Assign(s->assembly, s->padB, 'B');
+    } else if (forecastA <= 1*t && !PadFull(s->padA) && (forecastA < forecastB || PadFull(s->padB))) {
+        Assign(s->land, s->padA, 'A');
+    } else {
+        Assign(s->land, s->padB, 'B');
+    }
+    return 1;
+}
+
+// lookahead: binds jobs to pads as late as the completion forecasts allow, and sends
+// a landing where it delays the pad's own ground jobs the least
+int LookaheadDispatch(TowerState *s) {
+    int forecastA = PadForecast(s->padA, s->padA_job, s->padA_remaining);
+    int forecastB = PadForecast(s->padB, s->padB_job, s->padB_remaining);
+    int moved = 0;
+    if (!isEmpty(s->launch) && !PadFull(s->padA) && (forecastA <= 1*t || s->launch->size >= 3)) {
+        Assign(s->launch, s->padA, 'A');
+        forecastA += 2*t;
+        moved++;
+    }
+    if (!isEmpty(s->assembly) && !PadFull(s->padB) && (forecastB <= 1*t || s->assembly->size >= 3)) {
+        Assign(s->assembly, s->padB, 'B');
+        forecastB += 6*t;
+        moved++;
+    }
+    if (!isEmpty(s->land)) {
+        // every ground job waiting behind a pad is pushed back by the landing
+        int costA = forecastA + 1*t + s->launch->size * 1*t;
+        int costB = forecastB + 1*t + s->assembly->size * 1*t;
+        bool toA = !PadFull(s->padA) && (costA < costB || PadFull(s->padB));
+        int forecast = toA ? forecastA : forecastB;
+        if ((toA || !PadFull(s->padB)) && (forecast <= 1*t || s->land->size >= 3)) {
+            if (toA) {
+                Assign(s->land, s->padA, 'A');
+            } else {
+                Assign(s->land, s->padB, 'B');
+            }
+            moved++;
+        }
+    }
+    return moved;
+}
+
+Policy policies[] = {
+    { "default", NULL, DefaultDispatch },
+    { "sec", NULL, ShortestCompletionDispatch },
+    { "wfq", WeightedFairReset, WeightedFairDispatch },
+    { "lookahead", NULL, LookaheadDispatch },
+};
+
+#define POLICIES (int) (sizeof(policies) / sizeof(Policy))
+
+Policy *FindPolicy(char *name) {
+    for (int i = 0; i < POLICIES; i++) {
+        if (!strcmp(policies[i].name, name)) {
+            return &policies[i];
+        }
+    }
+    return NULL;
+}
@@ -11,6 +11,11 @@ typedef struct {
     int end_time;
     char type;
     char pad;
+    char interrupted;   // preempted and waiting to resume
+    char started;       // has been in service, remaining is what is left of it
+    int remaining;      // milliseconds of service left once started, 0 => finished
+    int interrupted_at; // milliseconds since start when it was preempted
+    int preempted;      // total milliseconds spent preempted
 } Job;
 
 /* a link in the queue, holds the data and point to the next Node */
@@ -34,6 +39,9 @@ int EnqueueFirst(Queue *pQueue, Job j);
 int EnqueueSecond(Queue *pQueue, Job j);
 Job Dequeue(Queue *pQueue);
 int isEmpty(Queue* pQueue);
+int isFull(Queue* pQueue);
+int UpdateJob(Queue *pQueue, Job j);
+int RemoveJob(Queue *pQueue, int ID);
 
 Queue *ConstructQueue(int limit) {
     Queue *queue = (Queue*) malloc(sizeof (Queue));
@@ -59,17 +67,15 @@ void DestructQueue(Queue *queue) {
 }
 
 int Enqueue(Queue *pQueue, Job j) {
-    /* Bad parameter */
-    NODE* item = (NODE*) malloc(sizeof (NODE));
-    item->data = j;
-
-    if ((pQueue == NULL) || (item == NULL)) {
+    /* Bad parameter or full queue, nothing is allocated */
+    if ((pQueue == NULL) || (pQueue->size >= pQueue->limit)) {
         return FALSE;
     }
-    // if(pQueue->limit != 0)
-    if (pQueue->size >= pQueue->limit) {
+    NODE* item = (NODE*) malloc(sizeof (NODE));
+    if (item == NULL) {
         return FALSE;
     }
+    item->data = j;
     /*the queue is empty*/
     item->prev = NULL;
     if (pQueue->size == 0) {
@@ -110,17 +116,27 @@ int isEmpty(Queue* pQueue) {
     }
 }
 
-int EnqueueFirst(Queue *pQueue, Job j) {
-    NODE* item = (NODE*) malloc(sizeof (NODE));
-    item->data = j;
-
-    if ((pQueue == NULL) || (item == NULL)) {
+int isFull(Queue* pQueue) {
+    if (pQueue == NULL) {
         return FALSE;
     }
-    // if(pQueue->limit != 0)
     if (pQueue->size >= pQueue->limit) {
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}
+
+int EnqueueFirst(Queue *pQueue, Job j) {
+    /* Bad parameter or full queue, nothing is allocated */
+    if ((pQueue == NULL) || (pQueue->size >= pQueue->limit)) {
         return FALSE;
     }
+    NODE* item = (NODE*) malloc(sizeof (NODE));
+    if (item == NULL) {
+        return FALSE;
+    }
+    item->data = j;
 
     /*the queue is empty*/
     item->prev = NULL;
@@ -138,16 +154,15 @@ int EnqueueFirst(Queue *pQueue, Job j) {
 }
 
 int EnqueueSecond(Queue *pQueue, Job j) {
-    NODE* item = (NODE*) malloc(sizeof (NODE));
-    item->data = j;
-
-    if ((pQueue == NULL) || (item == NULL)) {
+    /* Bad parameter or full queue, nothing is allocated */
+    if ((pQueue == NULL) || (pQueue->size >= pQueue->limit)) {
         return FALSE;
     }
-    // if(pQueue->limit != 0)
-    if (pQueue->size >= pQueue->limit) {
+    NODE* item = (NODE*) malloc(sizeof (NODE));
+    if (item == NULL) {
         return FALSE;
     }
+    item->data = j;
 
     /*the queue is empty*/
     item->prev = NULL;
@@ -166,3 +181,46 @@ int EnqueueSecond(Queue *pQueue, Job j) {
     pQueue->size++;
     return TRUE;
 }
+
+/* replaces the data of the queued job with the same ID */
+int UpdateJob(Queue *pQueue, Job j) {
+    if (pQueue == NULL) {
+        return FALSE;
+    }
+    NODE *item = pQueue->head;
+    while (item != NULL) {
+        if (item->data.ID == j.ID) {
+            item->data = j;
+            return TRUE;
+        }
+        item = item->prev;
+    }
+    return FALSE;
+}
+
+/* removes the job with the given ID wherever it is in the queue */
+int RemoveJob(Queue *pQueue, int ID) {
+    if (pQueue == NULL) {
+        return FALSE;
+    }
+    NODE *before = NULL;
+    NODE *item = pQueue->head;
+    while (item != NULL && item->data.ID != ID) {
+        before = item;
+        item = item->prev;
+    }
+    if (item == NULL) {
+        return FALSE;
+    }
+    if (before == NULL) {
+        pQueue->head = item->prev;
+    } else {
+        before->prev = item->prev;
+    }
+    if (pQueue->tail == item) {
+        pQueue->tail = before;
+    }
+    pQueue->size--;
+    free(item);
+    return TRUE;
+}
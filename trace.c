@@ -0,0 +1,152 @@
+/* opt-in timeline tracer: every thread appends events to its own buffer without
+   locking, the buffers are written as Chrome/Perfetto trace-event JSON at exit.
+   When tracing is off the TRACE_ macros cost a single branch. */
+
+#define TRACE_CHUNK 4096
+
+typedef struct {
+    const char *name;
+    const char *category;
+    char phase;              // 'X' complete, 'i' instant
+    char type;               // job type, 0 when the event is not about a job
+    int id;                  // job ID
+    long ts;                 // microseconds since tracing started
+    long dur;
+} TraceEvent;
+
+typedef struct TraceChunk_t {
+    TraceEvent events[TRACE_CHUNK];
+    int count;
+    struct TraceChunk_t *next;
+} TraceChunk;
+
+/* one per thread, only its owner writes to it until the final flush */
+typedef struct TraceBuffer_t {
+    const char *thread;
+    int tid;
+    TraceChunk *first;
+    TraceChunk *last;
+    struct TraceBuffer_t *next;
+} TraceBuffer;
+
+bool tracing = FALSE;
+TraceBuffer *trace_buffers = NULL;   // every registered buffer, pushed with a CAS
+int trace_threads = 0;
+struct timespec trace_start;
+__thread TraceBuffer *trace_buffer = NULL;
+
+#define TRACE_NOW() (tracing ? TraceNow() : 0)
+#define TRACE_THREAD(thread) do { if (tracing) TraceThread(thread); } while (0)
+#define TRACE_COMPLETE(name, category, start, id, type) \
+    do { if (tracing) TraceEventAdd(name, category, 'X', start, TraceNow() - (start), id, type); } while (0)
+#define TRACE_SPAN(name, category, start, end, id, type) \
+    do { if (tracing) TraceEventAdd(name, category, 'X', start, (end) - (start), id, type); } while (0)
+#define TRACE_INSTANT(name, category, id, type) \
+    do { if (tracing) TraceEventAdd(name, category, 'i', TraceNow(), 0, id, type); } while (0)
+
+#define TRACE_STALL_US 50    // lock waits shorter than this are not recorded
+
+const char *TraceJobName(char type) {
+    switch (type) {
+        case 'L': return "landing";
+        case 'D': return "launch";
+        case 'A': return "assembly";
+        default:  return "emergency";
+    }
+}
+
+void TraceStart() {
+    clock_gettime(CLOCK_MONOTONIC, &trace_start);
+    tracing = TRUE;
+}
+
+long TraceNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - trace_start.tv_sec) * 1000000L + (now.tv_nsec - trace_start.tv_nsec) / 1000;
+}
+
+// gives the calling thread its buffer, called once at the top of every thread
+void TraceThread(const char *thread) {
+    TraceBuffer *buffer = (TraceBuffer*) calloc(1, sizeof(TraceBuffer));
+    if (buffer == NULL) {
+        return;
+    }
+    buffer->thread = thread;
+    buffer->tid = __atomic_add_fetch(&trace_threads, 1, __ATOMIC_RELAXED);
+    buffer->next = __atomic_load_n(&trace_buffers, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_buffers, &buffer->next, buffer, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    trace_buffer = buffer;
+}
+
+void TraceEventAdd(const char *name, const char *category, char phase, long ts, long dur, int id, char type) {
+    TraceBuffer *buffer = trace_buffer;
+    if (buffer == NULL) {
+        return;
+    }
+    if (buffer->last == NULL || buffer->last->count == TRACE_CHUNK) {
+        TraceChunk *chunk = (TraceChunk*) malloc(sizeof(TraceChunk));
+        if (chunk == NULL) {
+            return;
+        }
+        chunk->count = 0;
+        chunk->next = NULL;
+        if (buffer->last == NULL) {
+            buffer->first = chunk;
+        } else {
+            buffer->last->next = chunk;
+        }
+        buffer->last = chunk;
+    }
+    TraceEvent *event = &buffer->last->events[buffer->last->count++];
+    event->name = name;
+    event->category = category;
+    event->phase = phase;
+    event->ts = ts;
+    event->dur = dur;
+    event->id = id;
+    event->type = type;
+}
+
+// writes every buffer as trace-event JSON, called after all threads are joined
+int TraceWrite(char *path) {
+    FILE *trace = fopen(path, "w");
+    if (trace == NULL) {
+        return -1;
+    }
+    setvbuf(trace, NULL, _IOFBF, 1 << 20);
+    fprintf(trace, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = TRUE;
+    TraceBuffer *buffer = __atomic_load_n(&trace_buffers, __ATOMIC_ACQUIRE);
+    while (buffer != NULL) {
+        fprintf(trace, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", buffer->tid, buffer->thread);
+        first = FALSE;
+        TraceChunk *chunk = buffer->first;
+        while (chunk != NULL) {
+            for (int i = 0; i < chunk->count; i++) {
+                TraceEvent *event = &chunk->events[i];
+                fprintf(trace, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%ld,", event->name, event->category, event->phase, event->ts);
+                if (event->phase == 'X') {
+                    fprintf(trace, "\"dur\":%ld,", event->dur);
+                } else {
+                    fprintf(trace, "\"s\":\"t\",");
+                }
+                fprintf(trace, "\"pid\":1,\"tid\":%d", buffer->tid);
+                if (event->type != 0) {
+                    fprintf(trace, ",\"args\":{\"id\":%d,\"type\":\"%c\"}", event->id, event->type);
+                }
+                fprintf(trace, "}");
+            }
+            TraceChunk *next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        TraceBuffer *next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+    fprintf(trace, "\n]}\n");
+    trace_buffers = NULL;
+    return fclose(trace);
+}